@@ -0,0 +1,220 @@
+/**
+ * @file bench.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief In-kernel microbenchmarks
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <apps/bench.hpp>
+#include <stdint.h>
+#include <stddef.h>
+#include <x86gprintrin.h>   // needed for __rdtsc
+#include <arch/arch.hpp>
+#include <mem/paging.hpp>
+#include <mem/heap.hpp>
+#include <mem/frames.hpp>
+#include <lib/string.hpp>
+#include <dev/vga/graphics.hpp>
+#include <sys/tasks.hpp>
+#include <dev/serial/rs232.hpp>
+
+#define BENCH_ITERATIONS    256
+// Roughly the working set a task touches between context switches
+#define BENCH_TLB_PAGES     256
+// Whole frames are slow to draw, uncached ones in particular
+#define BENCH_FB_ITERATIONS 16
+// Buffers are doubled from the first size up to the last one
+#define BENCH_REALLOC_FIRST         PAGE_SIZE
+#define BENCH_REALLOC_LAST          (16 * 1024 * 1024)
+#define BENCH_REALLOC_ITERATIONS    4
+
+typedef struct bench {
+    const char *name;
+    // Returns the average number of cycles of one iteration
+    uint32_t (*run)(void);
+} bench_t;
+
+// Function prototypes
+static void bench_touch(volatile uint8_t *buf, size_t pages);
+static uint32_t bench_tlb(bool flush_global);
+static uint32_t bench_tlb_cr3(void);
+static uint32_t bench_tlb_flush_all(void);
+static uint32_t bench_fb(page_cache_t cache, bool blit);
+static uint32_t bench_fb_fill_wb(void);
+static uint32_t bench_fb_fill_wc(void);
+static uint32_t bench_fb_fill_uc(void);
+static uint32_t bench_fb_blit_wb(void);
+static uint32_t bench_fb_blit_wc(void);
+static uint32_t bench_fb_blit_uc(void);
+static uint32_t bench_realloc(bool copy);
+static uint32_t bench_realloc_remap(void);
+static uint32_t bench_realloc_copy(void);
+static uint32_t bench_kmap_temp(void);
+
+static const bench_t benchmarks[] = {
+    { "context switch, CR3 reload (global kernel pages)", bench_tlb_cr3 },
+    { "context switch, full TLB flush (no global pages)", bench_tlb_flush_all },
+    { "framebuffer fill, write-back", bench_fb_fill_wb },
+    { "framebuffer fill, write-combining", bench_fb_fill_wc },
+    { "framebuffer fill, uncached", bench_fb_fill_uc },
+    { "framebuffer blit, write-back", bench_fb_blit_wb },
+    { "framebuffer blit, write-combining", bench_fb_blit_wc },
+    { "framebuffer blit, uncached", bench_fb_blit_uc },
+    { "realloc doubling 4 KiB to 16 MiB, grow or remap", bench_realloc_remap },
+    { "realloc doubling 4 KiB to 16 MiB, malloc and copy", bench_realloc_copy },
+    { "temporary frame mapping, kmap_temp and kunmap_temp", bench_kmap_temp },
+};
+
+static void bench_touch(volatile uint8_t *buf, size_t pages)
+{
+    for (size_t i = 0; i < pages; i++) {
+        (void)buf[i * PAGE_SIZE];
+    }
+}
+
+static uint32_t bench_tlb(bool flush_global)
+{
+    volatile uint8_t *buf = (volatile uint8_t *)get_new_page(BENCH_TLB_PAGES * PAGE_SIZE - 1);
+    if (buf == NULL) {
+        return 0;
+    }
+    size_t cr3;
+    asm volatile("mov %%cr3, %0" : "=r"(cr3));
+    bench_touch(buf, BENCH_TLB_PAGES);
+    // Keep the timer (and other tasks) from refilling the TLB behind our back
+    interrupts_disable();
+    uint64_t start = __rdtsc();
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        // This is what tasks_switch_to does between address spaces, and
+        // what every switch cost before kernel pages were marked global
+        if (flush_global) {
+            paging_flush_tlb();
+        } else {
+            asm volatile("mov %0, %%cr3" :: "r"(cr3) : "memory");
+        }
+        bench_touch(buf, BENCH_TLB_PAGES);
+    }
+    uint64_t cycles = __rdtsc() - start;
+    interrupts_enable();
+    free_page((void *)buf, BENCH_TLB_PAGES * PAGE_SIZE - 1);
+    return (uint32_t)(cycles / BENCH_ITERATIONS);
+}
+
+static uint32_t bench_tlb_cr3(void)
+{
+    return bench_tlb(false);
+}
+
+static uint32_t bench_tlb_flush_all(void)
+{
+    return bench_tlb(true);
+}
+
+static uint32_t bench_fb(page_cache_t cache, bool blit)
+{
+    size_t size = fb::size();
+    void *frame = blit ? malloc(size) : NULL;
+    if (size == 0 || (blit && frame == NULL)) {
+        return 0;
+    }
+    if (blit) {
+        memset(frame, 0x5A, size);
+    }
+    fb::setCaching(cache);
+    uint64_t start = __rdtsc();
+    for (size_t i = 0; i < BENCH_FB_ITERATIONS; i++) {
+        if (blit) {
+            fb::blit(frame);
+        } else {
+            fb::fill(i & 1 ? 0xFFFFFF : 0x000000);
+        }
+    }
+    uint64_t cycles = __rdtsc() - start;
+    // Leave the framebuffer the way fb::init() mapped it
+    fb::setCaching(PAGE_CACHE_WC);
+    free(frame);
+    return (uint32_t)(cycles / BENCH_FB_ITERATIONS);
+}
+
+static uint32_t bench_fb_fill_wb(void) { return bench_fb(PAGE_CACHE_WB, false); }
+static uint32_t bench_fb_fill_wc(void) { return bench_fb(PAGE_CACHE_WC, false); }
+static uint32_t bench_fb_fill_uc(void) { return bench_fb(PAGE_CACHE_UC, false); }
+static uint32_t bench_fb_blit_wb(void) { return bench_fb(PAGE_CACHE_WB, true); }
+static uint32_t bench_fb_blit_wc(void) { return bench_fb(PAGE_CACHE_WC, true); }
+static uint32_t bench_fb_blit_uc(void) { return bench_fb(PAGE_CACHE_UC, true); }
+
+static uint32_t bench_realloc(bool copy)
+{
+    uint64_t cycles = 0;
+    for (size_t i = 0; i < BENCH_REALLOC_ITERATIONS; i++) {
+        uint8_t *buf = NULL;
+        size_t used = 0;
+        uint64_t start = __rdtsc();
+        for (size_t size = BENCH_REALLOC_FIRST; size <= BENCH_REALLOC_LAST; size *= 2) {
+            uint8_t *grown;
+            if (copy) {
+                // What every resize cost before large blocks had pages of their own
+                grown = (uint8_t *)malloc(size);
+                if (grown != NULL && buf != NULL) {
+                    memcpy(grown, buf, used);
+                    free(buf);
+                }
+            } else {
+                grown = (uint8_t *)realloc(buf, size);
+            }
+            if (grown == NULL) {
+                free(buf);
+                return 0;
+            }
+            buf = grown;
+            // Fill the new half like a growing buffer would
+            for (size_t offset = used; offset < size; offset += PAGE_SIZE) {
+                buf[offset] = (uint8_t)offset;
+            }
+            used = size;
+        }
+        free(buf);
+        cycles += __rdtsc() - start;
+    }
+    return (uint32_t)(cycles / BENCH_REALLOC_ITERATIONS);
+}
+
+static uint32_t bench_realloc_remap(void) { return bench_realloc(false); }
+static uint32_t bench_realloc_copy(void) { return bench_realloc(true); }
+
+static uint32_t bench_kmap_temp(void)
+{
+    size_t frame = frames_alloc();
+    if (frame == SIZE_MAX) {
+        return 0;
+    }
+    uint64_t start = __rdtsc();
+    for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+        // Touch it so that the mapping is walked and not just written
+        volatile uint8_t *page = (volatile uint8_t *)kmap_temp(FRAME_TO_PHYS(frame));
+        if (page == NULL) {
+            break;
+        }
+        page[i] = (uint8_t)i;
+        kunmap_temp((void *)page);
+    }
+    uint64_t cycles = __rdtsc() - start;
+    frames_free(frame);
+    return (uint32_t)(cycles / BENCH_ITERATIONS);
+}
+
+namespace apps {
+
+void run_benchmarks(void)
+{
+    rs232::printf("Running %u kernel benchmarks...\n", sizeof(benchmarks) / sizeof(benchmarks[0]));
+    for (const bench_t &bench : benchmarks) {
+        rs232::printf("bench: %s: %u cycles\n", bench.name, bench.run());
+    }
+    tasks_exit();
+}
+
+}
@@ -0,0 +1,24 @@
+/**
+ * @file bench.hpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief In-kernel microbenchmarks
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#pragma once
+
+namespace apps {
+
+/**
+ * @brief Runs every kernel microbenchmark once, prints the results
+ * over serial and exits. Only started by kernels built with BENCHMARKS
+ * defined (make bench), since some of them measure hardware behaviour
+ * like TLB refills which the host unit tests cannot see.
+ *
+ */
+void run_benchmarks(void);
+
+}
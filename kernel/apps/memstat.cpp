@@ -0,0 +1,57 @@
+/**
+ * @file memstat.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Serial memory statistics console
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <apps/memstat.hpp>
+#include <stddef.h>
+#include <lib/string.hpp>
+#include <mem/memstats.hpp>
+#include <sys/tasks.hpp>
+#include <dev/serial/rs232.hpp>
+
+// Longest command line that is kept, the rest is dropped
+#define MEMSTAT_LINE_MAX    32
+// How often the serial input is checked
+#define MEMSTAT_POLL_MS     100
+
+namespace apps {
+
+void memstat(void) {
+    char line[MEMSTAT_LINE_MAX];
+    size_t len = 0;
+    while (true) {
+        char in;
+        // Serial input is buffered by the driver, so it is enough to
+        // look at it every now and then
+        while (rs232::read(&in, 1) == 1) {
+            if (in != '\n') {
+                if (len < MEMSTAT_LINE_MAX - 1) line[len++] = in;
+                continue;
+            }
+            line[len] = '\0';
+            if (len == 3 && memcmp(line, "mem", 3) == 0) {
+                mem_print_stats();
+            } else if (len == 7 && memcmp(line, "heap on", 7) == 0) {
+                rs232::printf(heap_profile_start() ? "Heap profiling started.\n" :
+                    "Unable to allocate the heap profile.\n");
+            } else if (len == 8 && memcmp(line, "heap off", 8) == 0) {
+                heap_profile_stop();
+            } else if (len == 4 && memcmp(line, "heap", 4) == 0) {
+                heap_profile_print();
+            } else if (len > 0) {
+                rs232::printf("Unknown command '%s', try 'mem' or 'heap [on|off]'.\n", line);
+            }
+            len = 0;
+        }
+        // Blocks rather than spinning, so the idle loop still gets to run
+        tasks_nano_sleep(MEMSTAT_POLL_MS * 1000ULL * 1000);
+    }
+}
+
+}
@@ -0,0 +1,23 @@
+/**
+ * @file memstat.hpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Serial memory statistics console
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#pragma once
+
+namespace apps {
+
+/**
+ * @brief Starts a task that prints the memory statistics whenever
+ * "mem" is entered over serial. "heap on" and "heap off" start and stop
+ * the heap profiler, "heap" prints its busiest call sites.
+ *
+ */
+void memstat(void);
+
+}
@@ -11,6 +11,8 @@
 #include <stddef.h>
 
 #include <lib/bitset.hpp>
+#include <mem/heap.hpp>
+#include <mem/paging.hpp>
 #include <lib/stdio.hpp>
 #include <sys/tasks.hpp>
 #include <apps/primes.hpp>
@@ -21,13 +23,22 @@ namespace apps {
 #define PRIME_MAX_SQRT 4000
 #define PRIME_MAX (PRIME_MAX_SQRT * PRIME_MAX_SQRT)
 #define PRIMES_SIZE (PRIME_MAX / (sizeof(size_t) * CHAR_BIT))
-static size_t primes[PRIMES_SIZE];
-static Bitset map = Bitset(primes, sizeof(primes));
+// Only allocated once the task runs instead of sitting in .bss. The sieve
+// writes every page right away, so the pages are backed up front rather
+// than faulted in one at a time.
+static size_t *primes = NULL;
+static Bitset map = Bitset(NULL, 0);
 
 static size_t prime_current;
 
 void find_primes(void)
 {
+    primes = (size_t *)get_new_page(PRIMES_SIZE * sizeof(size_t) - 1);
+    if (primes == NULL) {
+        prime_current = PRIME_MAX_SQRT;
+        return;
+    }
+    map = Bitset(primes, PRIMES_SIZE * sizeof(size_t));
     for (size_t i = 0; i < PRIMES_SIZE; i++)
         primes[i] = SIZE_MAX;
 
@@ -47,6 +58,11 @@ void show_primes(void)
         kprintf("\e[s\e[23;0fComputing primes: %%%u\e[u", pct);
     } while (prime_current < PRIME_MAX_SQRT);
 
+    if (primes == NULL) {
+        kprintf("\e[s\e[23;0fNot enough memory to compute primes.\e[u");
+        return;
+    }
+
     size_t count = 0;
     for (size_t i = 2; i < PRIME_MAX; i++) {
         count += map.Get(i);
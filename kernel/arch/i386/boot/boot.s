@@ -40,10 +40,11 @@ _start:
 
     # zero the early BSS to start things off well
     movl $_EARLY_BSS_SIZE, %ecx
-    xorb %al, %al
+    shrl $2, %ecx       # the linker pads it to a whole number of dwords
+    xorl %eax, %eax
     movl $_EARLY_BSS_START, %edi
     rep
-    stosb
+    stosl
 
     # identity map from 0x00000000 -> LOWMEM_END
     # WARNING: code assumes that the kernel won't be greater than 3MB
@@ -109,12 +110,18 @@ _start.higher:
     orl $0x80000000, %eax
     movl %eax, %cr0 # enable paging! make sure the next instruction fetch doesnt page fault
 
-    # zero the kernel BSS
+    # zero the kernel BSS, timed so that kernel_main can report it
+    rdtsc
+    movl %eax, bss_clear_cycles
     movl $_BSS_SIZE, %ecx
-    xorb %al, %al
+    shrl $2, %ecx       # the linker pads it to a whole number of dwords
+    xorl %eax, %eax
     movl $_BSS_START, %edi
     rep
-    stosb
+    stosl
+    rdtsc
+    subl bss_clear_cycles, %eax
+    movl %eax, bss_clear_cycles
 
     # adjust the stack in to the virtual area
     # setup and adjust the stack
@@ -182,6 +189,9 @@ multiboot_magic:
     .long 0
 multiboot_info:
     .long 0
+.global bss_clear_cycles
+bss_clear_cycles:      # TSC cycles spent zeroing the kernel BSS
+    .long 0
 no_sse_msg:
     .asciz "Error: No SSE support available!"
 
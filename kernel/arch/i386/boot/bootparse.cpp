@@ -67,12 +67,8 @@ static void print_acpi1_rsdp(struct RSDPDescriptor* rsdp)
 void parse_multiboot2(void *info)
 {
     auto fixed = (struct multiboot_fixed *) info;
-    for (uintptr_t page = ((uintptr_t)info & PAGE_ALIGN) + PAGE_SIZE;
-         page <= (((uintptr_t)info + fixed->total_size) & PAGE_ALIGN);
-         page += PAGE_SIZE) {
-        rs232::printf("Mapping bootinfo at 0x%08x\n", page);
-        map_kernel_page(VADDR(page), page);
-    }
+    rs232::printf("Mapping bootinfo at 0x%08x (%u bytes)\n", (uintptr_t)info, fixed->total_size);
+    map_kernel_range((uintptr_t)info, (uintptr_t)info, fixed->total_size, PAGE_MAP_WRITE);
     struct multiboot_tag *tag = (struct multiboot_tag*)((uintptr_t)fixed + sizeof(struct multiboot_fixed));
     while (tag->type != MULTIBOOT_TAG_TYPE_END) {
         switch (tag->type)
@@ -183,8 +179,7 @@ void parse_stivale2(void *info)
     while (tag)
     {
         // Map in each tag since Stivale2 doesn't give us a total size like Multiboot does.
-        uintptr_t page = ((uintptr_t)tag & PAGE_ALIGN);
-        map_kernel_page(VADDR(page), page);
+        map_kernel_range((uintptr_t)tag, (uintptr_t)tag, sizeof(*tag), PAGE_MAP_WRITE);
         // Follows the tag list order in stivale2.h
         switch(tag->identifier)
         {
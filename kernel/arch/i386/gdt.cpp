@@ -17,10 +17,8 @@
 
 // Defined in the gdt_flush.s file.
 extern "C" void gdt_flush(uintptr_t);
-// Function declarations
-void gdt_set_gate(uint8_t num, uint64_t base, uint64_t limit, uint16_t flags);
 // Define our local variables
-gdt_entry_t gdt_entries[5];
+gdt_entry_t gdt_entries[GDT_ENTRIES];
 gdt_ptr_t   gdt_ptr;
 
 void gdt_set_gate(uint8_t num, uint64_t base, uint64_t limit, uint16_t flags) {
@@ -53,7 +51,7 @@ void gdt_set_gate(uint8_t num, uint64_t base, uint64_t limit, uint16_t flags) {
 //gdt_flush((uintptr_t)gdtp);
 void gdt_install() {
     kprintf(DBG_INFO "Installing the GDT...\n");
-    gdt_ptr.limit = (sizeof(gdt_entry_t) * 5) - 1;
+    gdt_ptr.limit = (sizeof(gdt_entry_t) * GDT_ENTRIES) - 1;
     gdt_ptr.base  = (uint32_t)&gdt_entries;
 
     gdt_set_gate(0, 0, 0, 0);                     // Null segment
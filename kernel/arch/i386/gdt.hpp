@@ -44,6 +44,14 @@
 #define SEG_CODE_EXRDC       0x0E   // Execute/Read, conforming
 #define SEG_CODE_EXRDCA      0x0F   // Execute/Read, conforming, accessed
 
+// Available 32-bit task state segment (a system descriptor)
+#define GDT_TSS      SEG_TYPE(0) | SEG_PRES(1) | SEG_SAVL(0) | \
+                     SEG_LONG(0) | SEG_SIZE(0) | SEG_GRAN(0) | \
+                     SEG_PRIV(0) | 0x09
+
+// Null, kernel code/data, user code/data and three task state segments
+#define GDT_ENTRIES  8
+
 #define GDT_CODE_PL0 SEG_TYPE(1) | SEG_PRES(1) | SEG_SAVL(0) | \
                      SEG_LONG(0) | SEG_SIZE(1) | SEG_GRAN(1) | \
                      SEG_PRIV(0) | SEG_CODE_EXRD
@@ -91,3 +99,13 @@ typedef struct gdt_ptr gdt_ptr_t;
  *
  */
 extern void gdt_install();
+
+/**
+ * @brief Sets a GDT descriptor.
+ *
+ * @param num Descriptor index
+ * @param base Segment base address
+ * @param limit Segment limit
+ * @param flags Access byte and flags (see GDT_* above)
+ */
+extern void gdt_set_gate(uint8_t num, uint64_t base, uint64_t limit, uint16_t flags);
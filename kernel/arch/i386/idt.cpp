@@ -27,6 +27,17 @@ void idt_set_gate(int n, uint32_t handler_addr) {
     idt[n].high_offset = (uint16_t)(((handler_addr) >> 16) & 0xFFFF);
 }
 
+void idt_set_task_gate(int n, uint16_t tss_selector) {
+    idt[n].low_offset = 0;
+    idt[n].selector = tss_selector;
+    idt[n].always0 = 0;
+    idt[n].flags = 0x85; //    1 -> present bit,
+                         //   00 -> ring 0 privilege
+                         //    0 -> interrupt/trap gate
+                         // 0101 -> type: task gate
+    idt[n].high_offset = 0;
+}
+
 void load_idt() {
     kprintf(DBG_INFO "Loading the IDT...\n");
     idt_reg.base = (uint32_t) &idt;
@@ -57,6 +57,15 @@ extern idt_register_t idt_reg;
  * @param handler Handler address
  */
 void idt_set_gate(int n, uint32_t handler);
+/**
+ * @brief Turns an IDT entry into a task gate. The processor switches to
+ * the task whose task state segment is selected instead of calling a
+ * handler on the current stack.
+ *
+ * @param n IDT index
+ * @param tss_selector GDT selector of the task state segment
+ */
+void idt_set_task_gate(int n, uint16_t tss_selector);
 /**
  * @brief Calls the lidt instruction and installs the IDT onto the CPU.
  *
@@ -1,6 +1,8 @@
 # Defined in isr.c
 .extern isr_handler
 .extern irq_handler
+.extern tss_page_fault_handler
+.extern tss_double_fault_handler
 .align 4
 
 # Common ISR code
@@ -388,3 +390,21 @@ irq15:
         push $15
         push $47
         jmp irq_common_stub
+
+# Page faults and double faults are delivered through task gates so that
+# they run on a stack of their own. The processor switches to the task
+# and pushes the error code there. The iret switches back to the
+# interrupted task, and the next fault resumes right after it.
+.global page_fault_task
+page_fault_task:
+    call tss_page_fault_handler
+    addl $4, %esp       # Cleans up the error code
+    iret                # Returns to the interrupted task
+    jmp page_fault_task
+
+.global double_fault_task
+double_fault_task:
+    call tss_double_fault_handler
+    cli
+    hlt
+    jmp double_fault_task
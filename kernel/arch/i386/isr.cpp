@@ -68,6 +68,12 @@ extern "C" void register_interrupt_handler(uint8_t n, isr_t handler) {
 }
 
 extern "C" void isr_handler(registers_t *r) {
+    // Exceptions with a handler (such as page faults) may be recoverable
+    if (interrupt_handlers[r->int_num] != 0) {
+        isr_t handler = interrupt_handlers[r->int_num];
+        handler(r);
+        return;
+    }
     PANIC(r);
 }
 
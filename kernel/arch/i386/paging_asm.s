@@ -12,3 +12,28 @@ invalidate_page:
 #endif
     ret
 
+
+# void paging_enable_pae(uint32_t page_dir_ptrs)
+# CR4.PAE may only change with paging off, so this lives in the identity
+# mapped early kernel. The stack is in the higher half and is not touched
+# until paging is back on with the page directory pointer table in CR3,
+# and interrupts stay off in between.
+.section .early_text, "ax", @progbits
+.align 4
+
+.global paging_enable_pae
+paging_enable_pae:
+    movl    4(%esp),%edx
+    pushfl
+    cli
+    movl    %cr0,%ecx
+    andl    $0x7fffffff,%ecx
+    movl    %ecx,%cr0           # paging off
+    movl    %cr4,%eax
+    orl     $0x20,%eax
+    movl    %eax,%cr4           # CR4.PAE
+    movl    %edx,%cr3
+    orl     $0x80000000,%ecx
+    movl    %ecx,%cr0           # paging on with the new tables
+    popfl
+    ret
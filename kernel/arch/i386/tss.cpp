@@ -0,0 +1,108 @@
+/**
+ * @file tss.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Task state segments and the fault tasks
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <arch/arch.hpp>
+#include <arch/i386/tss.hpp>
+#include <sys/panic.hpp>
+#include <lib/stdio.hpp>
+#include <dev/tty/tty.hpp>
+
+#define KERNEL_DS       0x10
+// Only the reserved bit is set, so the fault tasks run with interrupts off
+#define TSS_EFLAGS      0x2
+
+extern "C" void page_fault_task();
+extern "C" void double_fault_task();
+
+// Receives the state of whatever was running when a task gate fires
+static tss_entry_t tss_kernel;
+static tss_entry_t tss_page_fault;
+static tss_entry_t tss_double_fault;
+static uint8_t page_fault_stack[TSS_FAULT_STACK_SIZE] __attribute__ ((aligned (16)));
+static uint8_t double_fault_stack[TSS_FAULT_STACK_SIZE] __attribute__ ((aligned (16)));
+
+// Function prototypes
+static void tss_init_task(tss_entry_t *tss, void (*entry)(), uint8_t *stack);
+static void tss_device_unavailable(registers_t *regs);
+static registers_t tss_interrupted_registers(uint32_t int_num, uint32_t err_code);
+
+static void tss_init_task(tss_entry_t *tss, void (*entry)(), uint8_t *stack)
+{
+    *tss = { /* Zero */ };
+    tss->eip = (uint32_t)entry;
+    tss->esp = (uint32_t)(stack + TSS_FAULT_STACK_SIZE);
+    tss->eflags = TSS_EFLAGS;
+    tss->cs = KERNEL_CS;
+    tss->ss = tss->ds = tss->es = tss->fs = tss->gs = KERNEL_DS;
+    tss->iomap_base = sizeof(tss_entry_t);
+}
+
+static void tss_device_unavailable(registers_t *regs)
+{
+    (void)regs;
+    // Every hardware task switch sets CR0.TS. Nothing saves FPU state
+    // lazily, so simply allow the instruction to run again.
+    asm volatile("clts");
+}
+
+static registers_t tss_interrupted_registers(uint32_t int_num, uint32_t err_code)
+{
+    return (registers_t) {
+        .ds = tss_kernel.ds,
+        .edi = tss_kernel.edi, .esi = tss_kernel.esi, .ebp = tss_kernel.ebp,
+        .ignored = tss_kernel.esp, .ebx = tss_kernel.ebx, .edx = tss_kernel.edx,
+        .ecx = tss_kernel.ecx, .eax = tss_kernel.eax,
+        .int_num = int_num, .err_code = err_code,
+        .eip = tss_kernel.eip, .cs = tss_kernel.cs, .eflags = tss_kernel.eflags,
+        .esp = tss_kernel.esp, .ss = tss_kernel.ss,
+    };
+}
+
+void tss_install()
+{
+    kprintf(DBG_INFO "Installing the TSS...\n");
+    uint32_t cr3;
+    asm volatile("mov %%cr3, %0" : "=r"(cr3));
+    tss_kernel = { /* Zero */ };
+    tss_kernel.ss0 = KERNEL_DS;
+    tss_kernel.iomap_base = sizeof(tss_entry_t);
+    tss_init_task(&tss_page_fault, page_fault_task, page_fault_stack);
+    tss_init_task(&tss_double_fault, double_fault_task, double_fault_stack);
+    tss_set_page_dir(cr3);
+    gdt_set_gate(TSS_KERNEL_SELECTOR / 8, (uint32_t)&tss_kernel, sizeof(tss_entry_t) - 1, GDT_TSS);
+    gdt_set_gate(TSS_PAGE_FAULT_SELECTOR / 8, (uint32_t)&tss_page_fault, sizeof(tss_entry_t) - 1, GDT_TSS);
+    gdt_set_gate(TSS_DOUBLE_FAULT_SELECTOR / 8, (uint32_t)&tss_double_fault, sizeof(tss_entry_t) - 1, GDT_TSS);
+    tss_flush();
+    register_interrupt_handler(ISR_DEVICE_UNAVAIL, tss_device_unavailable);
+    idt_set_task_gate(ISR_PAGE_FAULT, TSS_PAGE_FAULT_SELECTOR);
+    idt_set_task_gate(ISR_DOUBLE_FAULT, TSS_DOUBLE_FAULT_SELECTOR);
+    kprintf(DBG_OKAY "Installed the TSS.\n");
+}
+
+extern "C" void tss_set_page_dir(uint32_t page_dir)
+{
+    // The processor never saves CR3 when it switches away from a task,
+    // it only loads it when switching to one.
+    tss_kernel.cr3 = page_dir;
+    tss_page_fault.cr3 = page_dir;
+    tss_double_fault.cr3 = page_dir;
+}
+
+extern "C" void tss_page_fault_handler(uint32_t err_code)
+{
+    registers_t regs = tss_interrupted_registers(ISR_PAGE_FAULT, err_code);
+    isr_handler(&regs);
+}
+
+extern "C" void tss_double_fault_handler(uint32_t err_code)
+{
+    registers_t regs = tss_interrupted_registers(ISR_DOUBLE_FAULT, err_code);
+    PANIC(&regs);
+}
@@ -11,6 +11,14 @@
 #pragma once
 
 #include <stdint.h>
+#include <arch/arch.hpp>
+
+// GDT selectors of the task state segments
+#define TSS_KERNEL_SELECTOR         0x28
+#define TSS_PAGE_FAULT_SELECTOR     0x30
+#define TSS_DOUBLE_FAULT_SELECTOR   0x38
+// Stack used by each of the fault tasks
+#define TSS_FAULT_STACK_SIZE        4096
 
 /**
  * @brief This function is defined in flush.s (assembly) and is
@@ -62,3 +70,39 @@ typedef struct tss_entry {
     uint16_t    trap;
     uint16_t    iomap_base;
 } __attribute__ ((packed)) tss_entry_t;
+
+/**
+ * @brief Sets up the task state segments and loads the kernel's into the
+ * task register. Page faults and double faults are then delivered through
+ * task gates, which switch to a stack of their own. This is what allows a
+ * fault on an unbacked or guard page of the current stack to be handled
+ * instead of escalating into a triple fault.
+ *
+ */
+void tss_install();
+
+/**
+ * @brief Records the page directory that is active. A hardware task
+ * switch reloads CR3 from the task state segment it switches to, so the
+ * fault tasks and the return to the interrupted code must agree with it.
+ * Also called from tasks_switch_to() whenever it loads another directory.
+ *
+ * @param page_dir Physical address of the page directory
+ */
+extern "C" void tss_set_page_dir(uint32_t page_dir);
+
+/**
+ * @brief Called by the page fault task with the error code pushed by the
+ * processor. The state of the interrupted code is read back from the
+ * kernel task state segment.
+ *
+ * @param err_code Page fault error code
+ */
+extern "C" void tss_page_fault_handler(uint32_t err_code);
+
+/**
+ * @brief Called by the double fault task. Never returns.
+ *
+ * @param err_code Double fault error code (always zero)
+ */
+extern "C" void tss_double_fault_handler(uint32_t err_code);
@@ -33,14 +33,20 @@ namespace Boot {
 
 Handoff::Handoff()
     : _handle(NULL)
+    , _handleSize(0)
     , _magic(0)
+    , _memoryMapCount(0)
+    , _moduleCount(0)
 {
     // Initialize nothing.
 }
 
 Handoff::Handoff(void* handoff, uint32_t magic)
     : _handle(handoff)
+    , _handleSize(0)
     , _magic(magic)
+    , _memoryMapCount(0)
+    , _moduleCount(0)
 {
     const char* bootProtoName;
     // Parse the handle based on the magic
@@ -64,6 +70,69 @@ Handoff::~Handoff()
     // Nothing to deconstruct
 }
 
+void Handoff::addMemoryRegion(uint64_t base, uint64_t length, HandoffMemoryType type)
+{
+    if (_memoryMapCount >= HANDOFF_MEMORY_MAP_MAX) {
+        rs232::printf("Dropping memory map entry at 0x%08x (map is full)\n", (uint32_t)base);
+        return;
+    }
+    _memoryMap[_memoryMapCount++] = HandoffMemoryRegion(base, length, type);
+}
+
+void Handoff::addModule(uint64_t start, uint64_t end, const char* name)
+{
+    if (_moduleCount >= HANDOFF_MODULES_MAX) {
+        rs232::printf("Dropping module '%s' (too many modules)\n", name);
+        return;
+    }
+    if (end <= start || end > KERNEL_BASE) {
+        rs232::printf("Dropping module '%s' (unable to identity map it)\n", name);
+        return;
+    }
+    rs232::printf("Module '%s' at 0x%08x (%u bytes)\n", name, (uint32_t)start, (uint32_t)(end - start));
+    // Modules are only ever read, a stray write should fault
+    map_kernel_range((uintptr_t)start, (uint32_t)start, (size_t)(end - start), 0);
+    _modules[_moduleCount++] = HandoffModule(start, end - start, name);
+}
+
+HandoffModule::HandoffModule()
+    : _base(0)
+    , _length(0)
+    , _name("")
+{
+    // Default constructor.
+}
+
+HandoffModule::HandoffModule(uint64_t base, uint64_t length, const char* name)
+    : _base(base)
+    , _length(length)
+    , _name(name)
+{
+    // All parameters constructor
+}
+
+HandoffMemoryRegion::HandoffMemoryRegion()
+    : _base(0)
+    , _length(0)
+    , _type(MemoryReserved)
+{
+    // Default constructor.
+}
+
+HandoffMemoryRegion::HandoffMemoryRegion(uint64_t base, uint64_t length, HandoffMemoryType type)
+    : _base(base)
+    , _length(length)
+    , _type(type)
+{
+    // All parameters constructor
+}
+
+// Identity maps every page touched by [start, start + size)
+static void mapHandoffRange(uintptr_t start, size_t size)
+{
+    map_kernel_range(start, start, size, PAGE_MAP_WRITE);
+}
+
 /*
  *  ___ _   _          _     ___
  * / __| |_(_)_ ____ _| |___|_  )
@@ -79,8 +148,7 @@ void Handoff::parseStivale2(Handoff* that, void* handoff)
     while (tag)
     {
         // TODO: Find a way around this when the new memory manager code is done.
-        uintptr_t page = ((uintptr_t)tag & PAGE_ALIGN);
-        map_kernel_page(VADDR(page), page);
+        mapHandoffRange((uintptr_t)tag, sizeof(*tag));
         // Follows the tag list order in stivale2.h
         switch(tag->identifier)
         {
@@ -91,6 +159,39 @@ void Handoff::parseStivale2(Handoff* that, void* handoff)
                 that->_cmdline = (char *)(cmdline->cmdline);
                 break;
             }
+            case STIVALE2_STRUCT_TAG_MEMMAP_ID:
+            {
+                auto memmap = (struct stivale2_struct_tag_memmap*)tag;
+                // The entries may spill over onto the following pages
+                mapHandoffRange((uintptr_t)memmap, sizeof(*memmap));
+                mapHandoffRange((uintptr_t)memmap->memmap, memmap->entries * sizeof(struct stivale2_mmap_entry));
+                for (uint64_t i = 0; i < memmap->entries; i++) {
+                    auto entry = &memmap->memmap[i];
+                    HandoffMemoryType type;
+                    switch (entry->type) {
+                        case STIVALE2_MMAP_USABLE:                 type = MemoryUsable; break;
+                        case STIVALE2_MMAP_ACPI_RECLAIMABLE:       type = MemoryACPIReclaimable; break;
+                        case STIVALE2_MMAP_ACPI_NVS:               type = MemoryACPINVS; break;
+                        case STIVALE2_MMAP_BAD_MEMORY:             type = MemoryBad; break;
+                        case STIVALE2_MMAP_BOOTLOADER_RECLAIMABLE: type = MemoryBootloaderReclaimable; break;
+                        case STIVALE2_MMAP_KERNEL_AND_MODULES:     type = MemoryKernelAndModules; break;
+                        default:                                   type = MemoryReserved; break;
+                    }
+                    that->addMemoryRegion(entry->base, entry->length, type);
+                }
+                break;
+            }
+            case STIVALE2_STRUCT_TAG_MODULES_ID:
+            {
+                auto modules = (struct stivale2_struct_tag_modules*)tag;
+                mapHandoffRange((uintptr_t)modules, sizeof(*modules));
+                mapHandoffRange((uintptr_t)modules->modules, modules->module_count * sizeof(struct stivale2_module));
+                for (uint64_t i = 0; i < modules->module_count; i++) {
+                    auto module = &modules->modules[i];
+                    that->addModule(module->begin, module->end, module->string);
+                }
+                break;
+            }
             case STIVALE2_STRUCT_TAG_FRAMEBUFFER_ID:
             {
                 auto framebuffer = (struct stivale2_struct_tag_framebuffer*)tag;
@@ -159,12 +260,10 @@ void Handoff::parseMultiboot2(Handoff* that, void* handoff)
 {
     auto fixed = (struct multiboot_fixed *) handoff;
     // TODO: Find a way around this when the new memory manager code is done.
-    for (uintptr_t page = ((uintptr_t)handoff & PAGE_ALIGN) + PAGE_SIZE;
-         page <= (((uintptr_t)handoff + fixed->total_size) & PAGE_ALIGN);
-         page += PAGE_SIZE) {
-        rs232::printf("Mapping bootinfo at 0x%08x\n", page);
-        map_kernel_page(VADDR(page), page);
-    }
+    rs232::printf("Mapping bootinfo at 0x%08x (%u bytes)\n", (uintptr_t)handoff, fixed->total_size);
+    mapHandoffRange((uintptr_t)handoff, fixed->total_size);
+    // The boot information lives in usable memory, so it must be kept around
+    that->_handleSize = fixed->total_size;
     struct multiboot_tag *tag = (struct multiboot_tag*)((uintptr_t)fixed + sizeof(struct multiboot_fixed));
     while (tag->type != MULTIBOOT_TAG_TYPE_END) {
         switch (tag->type)
@@ -215,6 +314,32 @@ void Handoff::parseMultiboot2(Handoff* that, void* handoff)
                 );
                 break;
             }
+            case MULTIBOOT_TAG_TYPE_MODULE:
+            {
+                auto module = (struct multiboot_tag_module *)tag;
+                that->addModule(module->mod_start, module->mod_end, module->cmdline);
+                break;
+            }
+            case MULTIBOOT_TAG_TYPE_MMAP:
+            {
+                auto mmap = (struct multiboot_tag_mmap *)tag;
+                uint32_t remaining = mmap->size - sizeof(*mmap);
+                struct multiboot_mmap_entry *entry = mmap->entries;
+                while (remaining > 0) {
+                    HandoffMemoryType type;
+                    switch (entry->type) {
+                        case MULTIBOOT_MEMORY_AVAILABLE:        type = MemoryUsable; break;
+                        case MULTIBOOT_MEMORY_ACPI_RECLAIMABLE: type = MemoryACPIReclaimable; break;
+                        case MULTIBOOT_MEMORY_NVS:              type = MemoryACPINVS; break;
+                        case MULTIBOOT_MEMORY_BADRAM:           type = MemoryBad; break;
+                        default:                                type = MemoryReserved; break;
+                    }
+                    that->addMemoryRegion(entry->addr, entry->len, type);
+                    entry = (struct multiboot_mmap_entry *)((uintptr_t)entry + mmap->entry_size);
+                    remaining -= mmap->entry_size;
+                }
+                break;
+            }
             default:
             {
                 //rs232::printf("Unknown Multiboot2 tag: 0x%08X\n", tag->type);
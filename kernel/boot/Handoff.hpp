@@ -11,6 +11,7 @@
 #pragma once
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 // Generic devices
 #include <dev/vga/fb.hpp>
 
@@ -21,6 +22,56 @@ enum HandoffBootloaderType {
     Stivale2 = 1,
 };
 
+enum HandoffMemoryType {
+    MemoryUsable = 0,
+    MemoryReserved = 1,
+    MemoryACPIReclaimable = 2,
+    MemoryACPINVS = 3,
+    MemoryBad = 4,
+    MemoryBootloaderReclaimable = 5,
+    MemoryKernelAndModules = 6,
+};
+
+// Maximum number of memory map entries kept from the bootloader
+#define HANDOFF_MEMORY_MAP_MAX 64
+// Maximum number of boot modules kept from the bootloader
+#define HANDOFF_MODULES_MAX 8
+
+class HandoffMemoryRegion {
+public:
+    // Constructors
+    HandoffMemoryRegion();
+    HandoffMemoryRegion(uint64_t base, uint64_t length, HandoffMemoryType type);
+    // Getters
+    uint64_t getBase()                  { return _base; }
+    uint64_t getLength()                { return _length; }
+    HandoffMemoryType getType()         { return _type; }
+
+private:
+    uint64_t _base;
+    uint64_t _length;
+    HandoffMemoryType _type;
+};
+
+// A file loaded by the bootloader. It is identity mapped read-only and
+// stays where the bootloader put it, so the data is never copied.
+class HandoffModule {
+public:
+    // Constructors
+    HandoffModule();
+    HandoffModule(uint64_t base, uint64_t length, const char* name);
+    // Getters
+    uint64_t getBase()                  { return _base; }
+    uint64_t getLength()                { return _length; }
+    const void* getData()               { return (const void*)(uintptr_t)_base; }
+    const char* getName()               { return _name; }
+
+private:
+    uint64_t _base;
+    uint64_t _length;
+    const char* _name;
+};
+
 // Unused for now.
 class HandoffRSDPDescriptor {
 public:
@@ -85,9 +136,7 @@ private:
 
 // TODO: Remaining information to be made obtainable
 //  * PXE IP address (once we have a nice IP struct)
-//  * Memory map layout (once we have new memory manager)
 //  * Update Stivale2 to latest version & add missing
-//  * Kernel modules (linked list of some sort?)
 class Handoff {
 public:
     // Constructors
@@ -97,18 +146,30 @@ public:
     // Getters
     const char* getCmdLine()                    { return _cmdline; }
     const void* getHandle()                     { return _handle; }
+    size_t getHandleSize()                      { return _handleSize; }
     fb::FramebufferInfo getFramebufferInfo()    { return _fbInfo; }
     HandoffBootloaderType getBootType()         { return _bootType; }
+    size_t getMemoryMapCount()                  { return _memoryMapCount; }
+    HandoffMemoryRegion getMemoryRegion(size_t idx) { return _memoryMap[idx]; }
+    size_t getModuleCount()                     { return _moduleCount; }
+    HandoffModule getModule(size_t idx)         { return _modules[idx]; }
 
 private:
     static void parseStivale2(Handoff* that, void* handoff);
     static void parseMultiboot2(Handoff* that, void* handoff);
+    void addMemoryRegion(uint64_t base, uint64_t length, HandoffMemoryType type);
+    void addModule(uint64_t start, uint64_t end, const char* name);
 
     void* _handle;
+    size_t _handleSize;
     char* _cmdline;
     uint32_t _magic;
     fb::FramebufferInfo _fbInfo;
     HandoffBootloaderType _bootType;
+    HandoffMemoryRegion _memoryMap[HANDOFF_MEMORY_MAP_MAX];
+    size_t _memoryMapCount;
+    HandoffModule _modules[HANDOFF_MODULES_MAX];
+    size_t _moduleCount;
 };
 
 }; // !namespace Boot
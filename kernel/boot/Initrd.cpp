@@ -0,0 +1,273 @@
+/**
+ * @file Initrd.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Read-only access to tar and cpio archives loaded as boot modules
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <boot/Initrd.hpp>
+
+// ustar headers and data are padded to whole blocks
+#define TAR_BLOCK_SIZE      512
+#define TAR_NAME_OFFSET     0
+#define TAR_NAME_SIZE       100
+#define TAR_SIZE_OFFSET     124
+#define TAR_SIZE_SIZE       12
+#define TAR_TYPE_OFFSET     156
+#define TAR_MAGIC_OFFSET    257
+#define TAR_PREFIX_OFFSET   345
+#define TAR_PREFIX_SIZE     155
+// newc headers are a magic followed by thirteen 8 digit hex fields
+#define CPIO_HEADER_SIZE    110
+#define CPIO_MODE_OFFSET    14
+#define CPIO_SIZE_OFFSET    54
+#define CPIO_NAMESIZE_OFFSET 94
+#define CPIO_MODE_TYPE      0170000
+#define CPIO_MODE_REGULAR   0100000
+#define CPIO_ALIGN          4
+
+namespace Boot {
+
+// The archive read from the first boot module
+static Initrd bootInitrd;
+
+// Function prototypes
+static size_t initrdFieldLength(const char* field, size_t max);
+static bool initrdParseOctal(const uint8_t* field, size_t length, size_t* value);
+static bool initrdParseHex(const uint8_t* field, size_t* value);
+static bool initrdEquals(const char* a, const char* b, size_t length);
+static bool initrdMatch(const initrd_file_t* file, const char* path, size_t length);
+static const char* initrdSkipDot(const char* path, size_t* length);
+
+static size_t initrdFieldLength(const char* field, size_t max)
+{
+    size_t length = 0;
+    while (length < max && field[length] != '\0') {
+        length++;
+    }
+    return length;
+}
+
+static bool initrdParseOctal(const uint8_t* field, size_t length, size_t* value)
+{
+    // Padded with spaces or NULs on either side
+    size_t i = 0;
+    size_t result = 0;
+    while (i < length && field[i] == ' ') i++;
+    if (i == length || field[i] < '0' || field[i] > '7') {
+        return false;
+    }
+    for (; i < length && field[i] >= '0' && field[i] <= '7'; i++) {
+        if (result > (SIZE_MAX >> 3)) {
+            return false;
+        }
+        result = (result << 3) | (field[i] - '0');
+    }
+    *value = result;
+    return true;
+}
+
+static bool initrdParseHex(const uint8_t* field, size_t* value)
+{
+    uint32_t result = 0;
+    for (size_t i = 0; i < 8; i++) {
+        uint8_t c = field[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return false;
+        result = (result << 4) | digit;
+    }
+    *value = result;
+    return true;
+}
+
+static const char* initrdSkipDot(const char* path, size_t* length)
+{
+    for (;;) {
+        if (*length >= 1 && path[0] == '/') {
+            path++;
+            (*length)--;
+        } else if (*length >= 2 && path[0] == '.' && path[1] == '/') {
+            path += 2;
+            *length -= 2;
+        } else {
+            return path;
+        }
+    }
+}
+
+static bool initrdEquals(const char* a, const char* b, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        if (a[i] != b[i]) return false;
+    }
+    return true;
+}
+
+static bool initrdMatch(const initrd_file_t* file, const char* path, size_t length)
+{
+    size_t prefixLength = file->prefixLength;
+    const char* prefix = initrdSkipDot(file->prefix, &prefixLength);
+    size_t nameLength = file->nameLength;
+    const char* name = file->name;
+    if (prefixLength == 0) {
+        name = initrdSkipDot(name, &nameLength);
+    } else {
+        // prefix + '/' + name
+        if (length < prefixLength + 1 || path[prefixLength] != '/' ||
+            !initrdEquals(path, prefix, prefixLength)) {
+            return false;
+        }
+        path += prefixLength + 1;
+        length -= prefixLength + 1;
+    }
+    return length == nameLength && initrdEquals(path, name, length);
+}
+
+Initrd::Initrd()
+    : _data(NULL)
+    , _size(0)
+    , _format(InitrdUnknown)
+{
+    // Empty archive.
+}
+
+Initrd::Initrd(const void* data, size_t size)
+    : _data((const uint8_t*)data)
+    , _size(size)
+    , _format(InitrdUnknown)
+{
+    // Both formats start with a header of their own
+    if (size >= TAR_BLOCK_SIZE && _data[TAR_MAGIC_OFFSET + 0] == 'u' &&
+        _data[TAR_MAGIC_OFFSET + 1] == 's' && _data[TAR_MAGIC_OFFSET + 2] == 't' &&
+        _data[TAR_MAGIC_OFFSET + 3] == 'a' && _data[TAR_MAGIC_OFFSET + 4] == 'r') {
+        _format = InitrdTar;
+    } else if (size >= CPIO_HEADER_SIZE && _data[0] == '0' && _data[1] == '7' &&
+        _data[2] == '0' && _data[3] == '7' && _data[4] == '0' &&
+        (_data[5] == '1' || _data[5] == '2')) {
+        _format = InitrdCpio;
+    }
+}
+
+bool Initrd::next(size_t* cursor, initrd_file_t* file)
+{
+    switch (_format) {
+        case InitrdTar:     return nextTar(cursor, file);
+        case InitrdCpio:    return nextCpio(cursor, file);
+        default:            return false;
+    }
+}
+
+bool Initrd::find(const char* path, initrd_file_t* file)
+{
+    size_t length = initrdFieldLength(path, SIZE_MAX);
+    path = initrdSkipDot(path, &length);
+    size_t cursor = 0;
+    initrd_file_t entry;
+    while (next(&cursor, &entry)) {
+        if (initrdMatch(&entry, path, length)) {
+            *file = entry;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Initrd::getFileCount()
+{
+    size_t count = 0;
+    size_t cursor = 0;
+    initrd_file_t entry;
+    while (next(&cursor, &entry)) {
+        count++;
+    }
+    return count;
+}
+
+bool Initrd::nextTar(size_t* cursor, initrd_file_t* file)
+{
+    while (*cursor <= _size && _size - *cursor >= TAR_BLOCK_SIZE) {
+        const uint8_t* header = _data + *cursor;
+        // The archive ends with blocks of zeros
+        if (header[TAR_NAME_OFFSET] == '\0') {
+            return false;
+        }
+        size_t size;
+        if (!initrdParseOctal(header + TAR_SIZE_OFFSET, TAR_SIZE_SIZE, &size) ||
+            size > _size - *cursor - TAR_BLOCK_SIZE) {
+            return false;
+        }
+        size_t blocks = (size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE;
+        size_t start = *cursor + TAR_BLOCK_SIZE;
+        *cursor = start + blocks * TAR_BLOCK_SIZE;
+        // Only regular files, old archives leave the type empty
+        char type = header[TAR_TYPE_OFFSET];
+        if (type != '0' && type != '\0') {
+            continue;
+        }
+        file->name = (const char*)header + TAR_NAME_OFFSET;
+        file->nameLength = initrdFieldLength(file->name, TAR_NAME_SIZE);
+        file->prefix = (const char*)header + TAR_PREFIX_OFFSET;
+        file->prefixLength = initrdFieldLength(file->prefix, TAR_PREFIX_SIZE);
+        file->data = _data + start;
+        file->size = size;
+        return true;
+    }
+    return false;
+}
+
+bool Initrd::nextCpio(size_t* cursor, initrd_file_t* file)
+{
+    while (*cursor <= _size && _size - *cursor >= CPIO_HEADER_SIZE) {
+        const uint8_t* header = _data + *cursor;
+        size_t mode, size, nameSize;
+        if (header[0] != '0' || header[1] != '7' || header[2] != '0' ||
+            header[3] != '7' || header[4] != '0' || (header[5] != '1' && header[5] != '2') ||
+            !initrdParseHex(header + CPIO_MODE_OFFSET, &mode) ||
+            !initrdParseHex(header + CPIO_SIZE_OFFSET, &size) ||
+            !initrdParseHex(header + CPIO_NAMESIZE_OFFSET, &nameSize) ||
+            nameSize == 0 || nameSize > _size - *cursor - CPIO_HEADER_SIZE) {
+            return false;
+        }
+        const char* name = (const char*)header + CPIO_HEADER_SIZE;
+        // The name is NUL terminated and the header and name are padded together
+        size_t start = (*cursor + CPIO_HEADER_SIZE + nameSize + CPIO_ALIGN - 1) & ~(size_t)(CPIO_ALIGN - 1);
+        if (start > _size || size > _size - start) {
+            return false;
+        }
+        // The last entry is an empty file with a special name
+        static const char trailer[] = "TRAILER!!!";
+        if (nameSize == sizeof(trailer) && initrdEquals(name, trailer, nameSize)) {
+            return false;
+        }
+        *cursor = (start + size + CPIO_ALIGN - 1) & ~(size_t)(CPIO_ALIGN - 1);
+        if ((mode & CPIO_MODE_TYPE) != CPIO_MODE_REGULAR) {
+            continue;
+        }
+        file->prefix = "";
+        file->prefixLength = 0;
+        file->name = name;
+        file->nameLength = nameSize - 1;
+        file->data = _data + start;
+        file->size = size;
+        return true;
+    }
+    return false;
+}
+
+Initrd& getInitrd()
+{
+    return bootInitrd;
+}
+
+void setInitrd(const Initrd& initrd)
+{
+    bootInitrd = initrd;
+}
+
+}; // !namespace Boot
@@ -0,0 +1,97 @@
+/**
+ * @file Initrd.hpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Read-only access to tar and cpio archives loaded as boot modules
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+namespace Boot {
+
+enum InitrdFormat {
+    InitrdUnknown = 0,
+    InitrdTar = 1,      // POSIX ustar
+    InitrdCpio = 2,     // SVR4 "newc", with or without checksums
+};
+
+/**
+ * @brief A regular file inside an archive. Nothing is copied, all of the
+ * pointers point into the archive. Names are not NUL terminated. A tar
+ * entry may split its path into a prefix and a name, in which case the
+ * full path is prefix + '/' + name.
+ */
+typedef struct initrd_file {
+    const char* prefix;
+    size_t prefixLength;
+    const char* name;
+    size_t nameLength;
+    const void* data;
+    size_t size;
+} initrd_file_t;
+
+class Initrd {
+public:
+    // Constructors
+    Initrd();
+    Initrd(const void* data, size_t size);
+    // Getters
+    InitrdFormat getFormat()            { return _format; }
+    bool isValid()                      { return _format != InitrdUnknown; }
+    /**
+     * @brief Steps through the regular files of the archive.
+     *
+     * @param cursor Position in the archive, start with zero
+     * @param file Receives the next file
+     * @return true A file was found
+     * @return false The end of the archive was reached or it is malformed
+     */
+    bool next(size_t* cursor, initrd_file_t* file);
+    /**
+     * @brief Looks up a regular file by its path. Leading "/" and "./"
+     * are ignored on both sides.
+     *
+     * @param path Path of the file
+     * @param file Receives the file
+     * @return true The file exists
+     * @return false There is no such file
+     */
+    bool find(const char* path, initrd_file_t* file);
+    /**
+     * @brief Counts the regular files in the archive.
+     *
+     * @return size_t Number of files
+     */
+    size_t getFileCount();
+
+private:
+    bool nextTar(size_t* cursor, initrd_file_t* file);
+    bool nextCpio(size_t* cursor, initrd_file_t* file);
+
+    const uint8_t* _data;
+    size_t _size;
+    InitrdFormat _format;
+};
+
+/**
+ * @brief Gets the archive the kernel was booted with, so that any subsystem
+ * can look up its files. Not valid if there was none.
+ *
+ * @return Initrd& The boot archive
+ */
+Initrd& getInitrd();
+/**
+ * @brief Sets the archive returned by getInitrd(). Called once at boot with
+ * the first boot module.
+ *
+ * @param initrd The boot archive
+ */
+void setInitrd(const Initrd& initrd);
+
+}; // !namespace Boot
@@ -16,6 +16,8 @@
 // Memory management & paging
 #include <mem/heap.hpp>
 #include <mem/paging.hpp>
+#include <mem/memstats.hpp>
+#include <lib/string.hpp>
 // System library functions
 #include <sys/panic.hpp>
 #include <lib/assert.hpp>
@@ -45,6 +47,25 @@ static bool initialized = false;
 
 bool isInitialized() { return initialized; }
 
+static void mapFramebuffer(page_cache_t cache)
+{
+    // Changing the memory type of an existing mapping needs a TLB and
+    // cache flush, which is done once for the whole framebuffer
+    mmu_gather_t tlb;
+    mmu_gather_init(&tlb);
+    // Whole 4 MiB aligned runs only take a single TLB entry
+    map_kernel_range((uintptr_t)addr, (uintptr_t)addr, pitch * height,
+        PAGE_MAP_WRITE | PAGE_MAP_LARGE, cache, &tlb);
+    mmu_gather_finish(&tlb);
+}
+
+static inline uint32_t packColor(uint32_t color)
+{
+    return (((color >> b_shift) & 0xff) << 0) |
+           (((color >> g_shift) & 0xff) << 8) |
+           (((color >> r_shift) & 0xff) << 16);
+}
+
 static void testPattern() {
     const uint32_t BAR_COLOR[8] =
     {
@@ -89,14 +110,11 @@ void init(FramebufferInfo info)
     b_size = fbInfo.getBlueMaskSize();
     b_shift = fbInfo.getBlueMaskShift();
     pixelwidth = (depth / 8);
-    // Map in the framebuffer
+    // Map in the framebuffer. It is only ever written, so let the
+    // processor combine the stores into full bursts.
     rs232::printf("Mapping framebuffer...\n");
-    for (uintptr_t page = (uintptr_t)addr & PAGE_ALIGN;
-        page < (uintptr_t)addr + (pitch * height);
-        page += PAGE_SIZE)
-    {
-        map_kernel_page(VADDR(page), page);
-    }
+    mapFramebuffer(PAGE_CACHE_WC);
+    mem_stats_add(MEM_OWNER_FRAMEBUFFER, PAGE_ALIGN_UP(((uintptr_t)addr & ~PAGE_ALIGN) + pitch * height) / PAGE_SIZE);
 
     initialized = true;
     testPattern();
@@ -111,15 +129,54 @@ void pixel(uint32_t x, uint32_t y, uint32_t color)
     if ((x <= width) && (y <= height))
     {
         uint8_t *pixel = (uint8_t*)addr + (y * pitch) + (x * pixelwidth);
+        // A single store for 32-bit pixels
+        if (pixelwidth == 4) {
+            *(uint32_t *)pixel = packColor(color);
+            return;
+        }
         // Pixel information
         pixel[0] = (color >> b_shift) & 0xff;   // B
         pixel[1] = (color >> g_shift) & 0xff;   // G
         pixel[2] = (color >> r_shift) & 0xff;   // R
-        // Additional pixel information
-        if (pixelwidth == 4) pixel[3] = 0x00;
     }
 }
 
+void fill(uint32_t color)
+{
+    if (!initialized) return;
+    uint32_t packed = packColor(color);
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t *row = (uint8_t*)addr + (y * pitch);
+        if (pixelwidth == 4) {
+            uint32_t *px = (uint32_t *)row;
+            for (uint32_t x = 0; x < width; x++) px[x] = packed;
+            continue;
+        }
+        for (uint32_t x = 0; x < width; x++) {
+            row[x * pixelwidth + 0] = packed & 0xff;
+            row[x * pixelwidth + 1] = (packed >> 8) & 0xff;
+            row[x * pixelwidth + 2] = (packed >> 16) & 0xff;
+        }
+    }
+}
+
+void blit(const void *frame)
+{
+    if (!initialized) return;
+    memcpy(addr, frame, size());
+}
+
+size_t size()
+{
+    return initialized ? pitch * height : 0;
+}
+
+void setCaching(page_cache_t cache)
+{
+    if (!initialized) return;
+    mapFramebuffer(cache);
+}
+
 void putrect(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color)
 {
     // Ensure framebuffer information exists
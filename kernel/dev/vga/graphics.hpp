@@ -10,7 +10,9 @@
  */
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
 #include <dev/vga/fb.hpp>
+#include <mem/paging.hpp>
 
 namespace fb {
 
@@ -50,4 +52,33 @@ void pixel(uint32_t x, uint32_t y, uint32_t color);
  */
 void putrect(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color);
 
+/**
+ * @brief Fills the whole screen with a color.
+ *
+ * @param color Hex color
+ */
+void fill(uint32_t color);
+
+/**
+ * @brief Copies a whole frame to the screen.
+ *
+ * @param frame Frame of size() bytes laid out like the framebuffer
+ */
+void blit(const void *frame);
+
+/**
+ * @brief Returns the size of the framebuffer.
+ *
+ * @return size_t Size in bytes (0 if there is no framebuffer)
+ */
+size_t size();
+
+/**
+ * @brief Remaps the framebuffer with another memory type. It is mapped
+ * write-combining by init(), this is meant for comparing memory types.
+ *
+ * @param cache Memory type
+ */
+void setCaching(page_cache_t cache);
+
 };
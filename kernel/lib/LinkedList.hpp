@@ -11,6 +11,8 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <mem/slab.hpp>
+#include <lib/mutex.hpp>
 
 namespace LinkedList {
 
@@ -54,6 +56,40 @@ public:
     {
         // Complete constructor
     }
+    /**
+     * @brief Allocates a node from the slab cache for this node type.
+     * The cache is created the first time a node is allocated.
+     *
+     * @param size Size of the node
+     * @return void* Memory for the node or NULL if out of memory
+     */
+    static void* operator new(size_t size) noexcept
+    {
+        kmem_cache_t* nodes = __atomic_load_n(&cache, __ATOMIC_ACQUIRE);
+        if (nodes == NULL) {
+            // Two tasks may allocate the first node at the same time
+            mutex_lock(&cache_lock);
+            nodes = cache;
+            if (nodes == NULL) {
+                nodes = kmem_cache_create(CacheName(), size, 0, NULL);
+                __atomic_store_n(&cache, nodes, __ATOMIC_RELEASE);
+            }
+            mutex_unlock(&cache_lock);
+            if (nodes == NULL) {
+                return NULL;
+            }
+        }
+        return kmem_cache_alloc(nodes);
+    }
+    /**
+     * @brief Returns a node to its slab cache
+     *
+     * @param ptr Node to be freed
+     */
+    static void operator delete(void* ptr) noexcept
+    {
+        kmem_cache_free(cache, ptr);
+    }
     /**
      * @brief Return the data stored by the node
      *
@@ -109,11 +145,50 @@ public:
     }
 
 private:
+    /**
+     * @brief Names the cache after the stored type, e.g. "list_node<int>",
+     * so that the statistics tell the node types apart
+     *
+     * @return const char* Name of the cache
+     */
+    static const char* CacheName()
+    {
+        // The compiler spells out T in the function signature
+        const char* type = __PRETTY_FUNCTION__;
+        while (*type != '\0' && !(type[0] == 'T' && type[1] == ' ' && type[2] == '=')) {
+            type++;
+        }
+        type += *type != '\0' ? 4 : 0;
+        const char prefix[] = "list_node<";
+        size_t len = 0;
+        for (; prefix[len] != '\0'; len++) {
+            cache_name[len] = prefix[len];
+        }
+        while (*type != '\0' && *type != ';' && *type != ']' && len < sizeof(cache_name) - 2) {
+            cache_name[len++] = *type++;
+        }
+        cache_name[len++] = '>';
+        cache_name[len] = '\0';
+        return cache_name;
+    }
+
+    static kmem_cache_t* cache;
+    static mutex_t cache_lock;
+    static char cache_name[32];
     T data;
     LinkedListNode* next;
     LinkedListNode* prev;
 };
 
+template<typename T>
+kmem_cache_t* LinkedListNode<T>::cache = NULL;
+
+template<typename T>
+mutex_t LinkedListNode<T>::cache_lock("list_node");
+
+template<typename T>
+char LinkedListNode<T>::cache_name[32];
+
 template<typename T>
 class LinkedList {
 public:
@@ -40,3 +40,130 @@ size_t Bitset::FindFirstRangeClear(size_t count)
     }
     return SIZE_MAX;
 }
+
+SummaryBitset::SummaryBitset(void* buf, size_t size)
+    : mapSize(size)
+{
+    // Ensure pointer alignment
+    if ((uintptr_t)buf % alignof(bitmap_t) != 0) {
+        PANIC("Unaligned bitmap pointer");
+    }
+    // Each level has one bit for every word in the level below it
+    bitmap_t* storage = (bitmap_t*)buf;
+    size_t bits = size;
+    for (size_t level = 0; level < SUMMARY_BITSET_LEVELS; level++) {
+        levels[level] = storage;
+        levelWords[level] = Words(bits);
+        for (size_t i = 0; i < levelWords[level]; i++) {
+            storage[i] = 0;
+        }
+        // Bits past the end are marked as used so that they are never found
+        for (size_t i = bits; i < levelWords[level] * TypeSize(); i++) {
+            storage[Index(i)] |= (bitmap_t)1 << Offset(i);
+        }
+        storage += levelWords[level];
+        bits = levelWords[level];
+    }
+}
+
+void SummaryBitset::Set(size_t addr)
+{
+    for (size_t level = 0; level < SUMMARY_BITSET_LEVELS; level++) {
+        bitmap_t* word = &levels[level][Index(addr)];
+        *word |= (bitmap_t)1 << Offset(addr);
+        // The level above only changes once this word fills up
+        if (*word != ~(bitmap_t)0) break;
+        addr = Index(addr);
+    }
+}
+
+void SummaryBitset::Clear(size_t addr)
+{
+    for (size_t level = 0; level < SUMMARY_BITSET_LEVELS; level++) {
+        bitmap_t* word = &levels[level][Index(addr)];
+        bool full = *word == ~(bitmap_t)0;
+        *word &= ~((bitmap_t)1 << Offset(addr));
+        // The level above only changes if this word used to be full
+        if (!full) break;
+        addr = Index(addr);
+    }
+}
+
+size_t SummaryBitset::FindNextClearIn(size_t level, size_t from)
+{
+    bitmap_t* map = levels[level];
+    size_t idx = Index(from);
+    if (idx >= levelWords[level]) {
+        return SIZE_MAX;
+    }
+    // Check what is left of the starting word
+    bitmap_t word = ~map[idx] & (~(bitmap_t)0 << Offset(from));
+    if (word) {
+        return idx * TypeSize() + __builtin_ctzl(word);
+    }
+    // Ask the level above for the next word that isn't full. The top
+    // level is small enough to be scanned directly.
+    if (level + 1 < SUMMARY_BITSET_LEVELS) {
+        idx = FindNextClearIn(level + 1, idx + 1);
+        if (idx == SIZE_MAX) {
+            return SIZE_MAX;
+        }
+    } else {
+        do {
+            if (++idx >= levelWords[level]) {
+                return SIZE_MAX;
+            }
+        } while (map[idx] == ~(bitmap_t)0);
+    }
+    return idx * TypeSize() + __builtin_ctzl(~map[idx]);
+}
+
+size_t SummaryBitset::FindNextBitClear(size_t from)
+{
+    if (from >= mapSize) {
+        return SIZE_MAX;
+    }
+    return FindNextClearIn(0, from);
+}
+
+size_t SummaryBitset::FindNextSetBefore(size_t from, size_t limit)
+{
+    bitmap_t* map = levels[0];
+    size_t idx = Index(from);
+    if (from >= limit) {
+        return limit;
+    }
+    // Skip over empty words
+    bitmap_t word = map[idx] & (~(bitmap_t)0 << Offset(from));
+    while (!word) {
+        if (++idx >= levelWords[0] || idx * TypeSize() >= limit) {
+            return limit;
+        }
+        word = map[idx];
+    }
+    size_t bit = idx * TypeSize() + __builtin_ctzl(word);
+    return bit < limit ? bit : limit;
+}
+
+size_t SummaryBitset::FindNextBitSet(size_t from)
+{
+    return FindNextSetBefore(from, mapSize);
+}
+
+size_t SummaryBitset::FindFirstRangeClear(size_t count)
+{
+    if (count == 0 || count > mapSize) {
+        return SIZE_MAX;
+    }
+    // Hop from the start of one clear run to the next until one is long enough
+    size_t start = FindNextBitClear(0);
+    while (start != SIZE_MAX && mapSize - start >= count) {
+        // No need to look any further than the end of the run we want
+        size_t end = FindNextSetBefore(start, start + count);
+        if (end - start >= count) {
+            return start;
+        }
+        start = FindNextBitClear(end);
+    }
+    return SIZE_MAX;
+}
@@ -34,3 +34,74 @@ private:
     ALWAYS_INLINE size_t Index(size_t bit) { return bit / TypeSize(); }
     ALWAYS_INLINE size_t Offset(size_t bit) { return bit % TypeSize(); }
 };
+
+// Number of levels kept by a SummaryBitset (the bitmap plus two summaries)
+#define SUMMARY_BITSET_LEVELS 3
+
+/**
+ * @brief A bitmap with a hierarchy of summary bitmaps on top of it. Every
+ * summary bit is set when the word it covers in the level below is full,
+ * so searches for clear bits skip entire full words (and full groups of
+ * words) with a single comparison and use count-trailing-zeros to land on
+ * the right bit. The summaries are kept up to date by Set() and Clear().
+ * All levels live in one caller-provided buffer of StorageWords() words.
+ */
+class SummaryBitset {
+public:
+    typedef size_t bitmap_t;
+    static ALWAYS_INLINE constexpr size_t TypeSize() { return sizeof(bitmap_t) * CHAR_BIT; }
+    static ALWAYS_INLINE constexpr size_t Words(size_t bits) { return (bits + TypeSize() - 1) / TypeSize(); }
+    /**
+     * @brief Computes the number of words needed to hold a map and its summaries.
+     *
+     * @param bits Number of bits in the map
+     * @return size_t Size of the storage buffer in words
+     */
+    static ALWAYS_INLINE constexpr size_t StorageWords(size_t bits) {
+        return Words(bits) + Words(Words(bits)) + Words(Words(Words(bits)));
+    }
+
+    /**
+     * @brief Construct a new summary bitset. Every bit starts out clear.
+     *
+     * @param buf Storage buffer of at least StorageWords(size) words
+     * @param size Number of bits in the map
+     */
+    SummaryBitset(void* buf, size_t size);
+    ALWAYS_INLINE size_t Size() { return mapSize; }
+    ALWAYS_INLINE bool Get(size_t addr) { return levels[0][Index(addr)] >> Offset(addr) & 1; }
+    void Set(size_t addr);
+    void Clear(size_t addr);
+    /**
+     * @brief Finds the first clear bit at or after a given bit.
+     *
+     * @param from Bit to start searching at
+     * @return size_t Index of the clear bit or SIZE_MAX if there is none
+     */
+    size_t FindNextBitClear(size_t from);
+    /**
+     * @brief Finds the first set bit at or after a given bit.
+     *
+     * @param from Bit to start searching at
+     * @return size_t Index of the set bit or Size() if there is none
+     */
+    size_t FindNextBitSet(size_t from);
+    ALWAYS_INLINE size_t FindFirstBitClear() { return FindNextBitClear(0); }
+    /**
+     * @brief Finds the first run of count clear bits. Unlike Bitset, runs
+     * are not limited to the width of a word.
+     *
+     * @param count Length of the run
+     * @return size_t Index of the first bit of the run or SIZE_MAX if there is none
+     */
+    size_t FindFirstRangeClear(size_t count);
+
+private:
+    bitmap_t* levels[SUMMARY_BITSET_LEVELS];
+    size_t levelWords[SUMMARY_BITSET_LEVELS];
+    size_t mapSize;
+    ALWAYS_INLINE size_t Index(size_t bit) { return bit / TypeSize(); }
+    ALWAYS_INLINE size_t Offset(size_t bit) { return bit % TypeSize(); }
+    size_t FindNextClearIn(size_t level, size_t from);
+    size_t FindNextSetBefore(size_t from, size_t limit);
+};
@@ -17,11 +17,15 @@
 #include <lib/stdio.hpp>
 // Bootloader
 #include <boot/Handoff.hpp>
+#include <boot/Initrd.hpp>
 // Memory management & paging
 #include <mem/heap.hpp>
 #include <mem/paging.hpp>
+#include <mem/frames.hpp>
+#include <mem/reclaim.hpp>
 // Architecture specific code
 #include <arch/arch.hpp>
+#include <arch/i386/tss.hpp>
 // Generic devices
 #include <dev/vga/fb.hpp>
 #include <dev/vga/graphics.hpp>
@@ -33,10 +37,16 @@
 // Apps
 #include <apps/primes.hpp>
 #include <apps/spinner.hpp>
+#include <apps/memstat.hpp>
+#ifdef BENCHMARKS
+#include <apps/bench.hpp>
+#endif
 // Debug
 #include <lib/assert.hpp>
 
 static Boot::Handoff handoff;
+// Measured by boot.s around zeroing the kernel BSS
+extern uint32_t bss_clear_cycles;
 
 static void kernel_print_splash();
 static void kernel_boot_tone();
@@ -47,12 +57,34 @@ static void boot_init(void *boot_info, uint32_t magic)
     // TODO: Find a way to avoid this until after parsing
     if (boot_info != NULL) {
         uintptr_t page = (uintptr_t)boot_info & PAGE_ALIGN;
-        map_kernel_page(VADDR(page), page);
+        map_kernel_range(page, page, PAGE_SIZE, PAGE_MAP_WRITE);
     }
     // Parse the bootloader information into common format
     handoff = Boot::Handoff(boot_info, magic);
     // Ensure handoff is no longer default initialized
     assert(handoff.getHandle());
+    // The first module is the initrd, it is read straight out of module memory
+    if (handoff.getModuleCount() > 0) {
+        auto module = handoff.getModule(0);
+        Boot::setInitrd(Boot::Initrd(module.getData(), (size_t)module.getLength()));
+        Boot::Initrd& initrd = Boot::getInitrd();
+        if (initrd.isValid()) {
+            size_t cursor = 0;
+            Boot::initrd_file_t file;
+            while (initrd.next(&cursor, &file)) {
+                // names point into the archive and are not terminated
+                rs232::printf("initrd: ");
+                if (file.prefixLength) {
+                    rs232::write(file.prefix, file.prefixLength);
+                    rs232::write("/", 1);
+                }
+                rs232::write(file.name, file.nameLength);
+                rs232::printf(" (%u bytes)\n", file.size);
+            }
+        } else {
+            rs232::printf("initrd: module '%s' is not a tar or cpio archive\n", module.getName());
+        }
+    }
 }
 
 /**
@@ -66,12 +98,17 @@ void kernel_main(void *boot_info, uint32_t magic) {
     interrupts_disable();
     gdt_install();                  // Initialize the Global Descriptor Table
     isr_install();                  // Initialize Interrupt Service Requests
+    tss_install();                  // Deliver page and double faults on stacks of their own
     rs232::init(RS_232_COM1);        // RS232 Serial
+    rs232::printf("boot: %u KiB of .bss cleared in %u cycles\n",
+        (BSS_END - BSS_START) / 1024, bss_clear_cycles);
     paging_init(0);                 // Initialize paging service (0 is placeholder)
     boot_init(boot_info, magic);    // Initialize bootloader information
                                     // TODO: Bootloader should be first but currently
                                     //       requires paging, which should come after
                                     //       boot information is parsed.
+    frames_init(handoff);           // Initialize physical frame allocator from the memory map
+    reclaim_init();                 // Set the free memory watermarks
     fb::init(handoff.getFramebufferInfo());
     kbd_init();                     // Initialize PS/2 Keyboard
     rtc_init();                     // Initialize Real Time Clock
@@ -88,10 +125,16 @@ void kernel_main(void *boot_info, uint32_t magic) {
     rs232::printf("%s\n%s\n", vendor, model);
 
     tasks_init();
-    task_t compute, status, spinner;
+    task_t compute, status, spinner, memstat, reclaim;
+    tasks_new(reclaim_task, &reclaim, TASK_READY, "reclaim");
     tasks_new(apps::find_primes, &compute, TASK_READY, "prime_compute");
     tasks_new(apps::show_primes, &status, TASK_READY, "prime_display");
     tasks_new(apps::spinner, &spinner, TASK_READY, "spinner");
+    tasks_new(apps::memstat, &memstat, TASK_READY, "memstat");
+#ifdef BENCHMARKS
+    task_t bench;
+    tasks_new(apps::run_benchmarks, &bench, TASK_READY, "benchmarks");
+#endif
 
     // Now that we're done make a joyful noise
     kernel_boot_tone();
@@ -0,0 +1,168 @@
+/**
+ * @file arena.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Bump allocator for short-lived kernel allocations
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <mem/arena.hpp>
+#include <mem/paging.hpp>
+#include <mem/memstats.hpp>
+
+#define ARENA_HEADER_SIZE   ((sizeof(arena_chunk_t) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+// Function prototypes
+static inline void arena_use(arena_t *arena, arena_chunk_t *chunk);
+static inline uintptr_t arena_align(uintptr_t pos, size_t align);
+static arena_chunk_t *arena_new_chunk(size_t size);
+
+static inline void arena_use(arena_t *arena, arena_chunk_t *chunk)
+{
+    arena->chunk = chunk;
+    arena->pos = (uintptr_t)chunk + ARENA_HEADER_SIZE;
+    arena->end = (uintptr_t)chunk + chunk->size;
+}
+
+static inline uintptr_t arena_align(uintptr_t pos, size_t align)
+{
+    return (pos + align - 1) & ~(uintptr_t)(align - 1);
+}
+
+static arena_chunk_t *arena_new_chunk(size_t size)
+{
+    // Room for the header and enough slack to align the allocation
+    if (size > SIZE_MAX - ARENA_HEADER_SIZE - PAGE_SIZE) {
+        return NULL;
+    }
+    size_t bytes = PAGE_ALIGN_UP(size + ARENA_HEADER_SIZE);
+    if (bytes < ARENA_CHUNK_SIZE) {
+        bytes = ARENA_CHUNK_SIZE;
+    }
+    arena_chunk_t *chunk = (arena_chunk_t *)get_new_page(bytes - 1);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    chunk->next = NULL;
+    chunk->size = bytes;
+    chunk->owned = true;
+    mem_stats_add(MEM_OWNER_ARENAS, bytes / PAGE_SIZE);
+    return chunk;
+}
+
+void arena_init(arena_t *arena, const char *name)
+{
+    *arena = {
+        .name = name,
+        .first = NULL,
+        .chunk = NULL,
+        .pos = 0,
+        .end = 0,
+        .fixed = false,
+    };
+}
+
+void arena_init_fixed(arena_t *arena, const char *name, void *buf, size_t size)
+{
+    arena_init(arena, name);
+    arena->fixed = true;
+    if (size <= ARENA_HEADER_SIZE) {
+        return;
+    }
+    arena_chunk_t *chunk = (arena_chunk_t *)buf;
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->owned = false;
+    arena->first = chunk;
+    arena_use(arena, chunk);
+}
+
+void *arena_alloc(arena_t *arena, size_t size, size_t align)
+{
+    uintptr_t ptr = arena_align(arena->pos, align);
+    if (arena->chunk != NULL && ptr >= arena->pos && ptr <= arena->end && size <= arena->end - ptr) {
+        arena->pos = ptr + size;
+        return (void *)ptr;
+    }
+    // Move on to a chunk that is left over from before the last reset,
+    // skipping any that are too small for this allocation
+    arena_chunk_t *prev = arena->chunk;
+    arena_chunk_t *next = prev != NULL ? prev->next : arena->first;
+    while (next != NULL) {
+        ptr = arena_align((uintptr_t)next + ARENA_HEADER_SIZE, align);
+        if (ptr <= (uintptr_t)next + next->size && size <= (uintptr_t)next + next->size - ptr) {
+            arena_use(arena, next);
+            arena->pos = ptr + size;
+            return (void *)ptr;
+        }
+        prev = next;
+        next = next->next;
+    }
+    if (arena->fixed || align > PAGE_SIZE || size > SIZE_MAX - align) {
+        return NULL;
+    }
+    arena_chunk_t *chunk = arena_new_chunk(size + align);
+    if (chunk == NULL) {
+        return NULL;
+    }
+    // The new chunk goes after every other one so that the order of the
+    // list keeps matching the order of allocation
+    if (prev == NULL) {
+        arena->first = chunk;
+    } else {
+        prev->next = chunk;
+    }
+    arena_use(arena, chunk);
+    ptr = arena_align(arena->pos, align);
+    arena->pos = ptr + size;
+    return (void *)ptr;
+}
+
+void arena_reset(arena_t *arena, arena_mark_t mark)
+{
+    if (mark.chunk == NULL) {
+        // marked before the first allocation
+        if (arena->first != NULL) {
+            arena_use(arena, arena->first);
+        }
+        return;
+    }
+    arena->chunk = mark.chunk;
+    arena->pos = mark.pos;
+    arena->end = (uintptr_t)mark.chunk + mark.chunk->size;
+}
+
+size_t arena_trim(arena_t *arena)
+{
+    arena_chunk_t **link = arena->chunk != NULL ? &arena->chunk->next : &arena->first;
+    size_t bytes = 0;
+    // chunks given by the caller of arena_init_fixed() are kept
+    while (*link != NULL) {
+        arena_chunk_t *chunk = *link;
+        if (!chunk->owned) {
+            link = &chunk->next;
+            continue;
+        }
+        *link = chunk->next;
+        bytes += chunk->size;
+        mem_stats_sub(MEM_OWNER_ARENAS, chunk->size / PAGE_SIZE);
+        free_page(chunk, chunk->size - 1);
+    }
+    return bytes;
+}
+
+void arena_release(arena_t *arena)
+{
+    arena_reset(arena, (arena_mark_t) { .chunk = NULL, .pos = 0 });
+    arena_chunk_t *first = arena->first;
+    if (first != NULL && !first->owned) {
+        // keep the fixed buffer, drop whatever follows it
+        arena_trim(arena);
+        return;
+    }
+    arena->chunk = NULL;
+    arena->pos = arena->end = 0;
+    arena_trim(arena);
+}
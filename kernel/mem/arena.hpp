@@ -0,0 +1,135 @@
+/**
+ * @file arena.hpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Bump allocator for short-lived kernel allocations
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Pages requested for a chunk unless the allocation needs more
+#define ARENA_CHUNK_SIZE    (4 * 4096)
+// Default alignment, enough for any scalar type
+#define ARENA_ALIGN         8
+
+typedef struct arena_chunk {
+    struct arena_chunk *next;   // Chunk used once this one is full
+    size_t size;                // Size of the chunk including this header
+    bool owned;                 // Chunk came from get_new_page()
+} arena_chunk_t;
+
+/**
+ * @brief An arena hands out memory by moving a pointer through a list of
+ * page-backed chunks. Nothing is freed individually; instead everything
+ * allocated after a mark goes away at once when the arena is reset to it.
+ * Chunks are kept for reuse until the arena is trimmed or released.
+ *
+ * An arena has no lock, it must only be used by a single task at a time.
+ */
+typedef struct arena {
+    const char *name;
+    arena_chunk_t *first;       // Oldest chunk
+    arena_chunk_t *chunk;       // Chunk that is allocated from
+    uintptr_t pos;              // Next free byte in chunk
+    uintptr_t end;              // End of chunk
+    bool fixed;                 // Never grows past the chunks it was given
+} arena_t;
+
+/**
+ * @brief A position in an arena to return to with arena_reset().
+ */
+typedef struct arena_marker {
+    arena_chunk_t *chunk;
+    uintptr_t pos;
+} arena_mark_t;
+
+/**
+ * @brief Initializes an empty arena. No memory is taken until the first
+ * allocation.
+ *
+ * @param arena Arena to initialize
+ * @param name Name used for diagnostics
+ */
+void arena_init(arena_t *arena, const char *name);
+
+/**
+ * @brief Initializes an arena on top of a caller provided buffer. The arena
+ * never asks for pages, so it can be used where the paging code cannot be
+ * relied on.
+ *
+ * @param arena Arena to initialize
+ * @param name Name used for diagnostics
+ * @param buf Buffer to allocate from (aligned to ARENA_ALIGN)
+ * @param size Size of the buffer in bytes
+ */
+void arena_init_fixed(arena_t *arena, const char *name, void *buf, size_t size);
+
+/**
+ * @brief Allocates memory from an arena.
+ *
+ * @param arena Arena to allocate from
+ * @param size Number of bytes
+ * @param align Alignment of the allocation (a power of two)
+ * @return void* Memory or NULL if no chunk could be found or made
+ */
+void *arena_alloc(arena_t *arena, size_t size, size_t align = ARENA_ALIGN);
+
+/**
+ * @brief Records the current position of an arena.
+ *
+ * @param arena Arena to mark
+ * @return arena_mark_t Mark to pass to arena_reset()
+ */
+static inline arena_mark_t arena_mark(arena_t *arena)
+{
+    return (arena_mark_t) { .chunk = arena->chunk, .pos = arena->pos };
+}
+
+/**
+ * @brief Frees everything allocated since a mark was taken. This only
+ * moves the allocation pointer back, later chunks stay around for reuse.
+ *
+ * @param arena Arena to reset
+ * @param mark Mark taken from the same arena
+ */
+void arena_reset(arena_t *arena, arena_mark_t mark);
+
+/**
+ * @brief Returns the chunks that are past the current position to the
+ * paging code.
+ *
+ * @param arena Arena to trim
+ * @return size_t Number of bytes given back
+ */
+size_t arena_trim(arena_t *arena);
+
+/**
+ * @brief Frees every allocation and every chunk of an arena. The arena
+ * can be used again afterwards.
+ *
+ * @param arena Arena to release
+ */
+void arena_release(arena_t *arena);
+
+/**
+ * @brief Frees everything allocated from an arena during the lifetime of
+ * the scope.
+ */
+class ArenaScope {
+public:
+    explicit ArenaScope(arena_t *arena) : _arena(arena), _mark(arena_mark(arena)) { }
+    ~ArenaScope() { arena_reset(_arena, _mark); }
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+    void *Alloc(size_t size, size_t align = ARENA_ALIGN) { return arena_alloc(_arena, size, align); }
+
+private:
+    arena_t *_arena;
+    arena_mark_t _mark;
+};
@@ -0,0 +1,178 @@
+/**
+ * @file buddy.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Binary buddy allocator used to manage physical frames
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <mem/buddy.hpp>
+#include <sys/panic.hpp>
+
+// Order byte of a frame that is not the head of a free block
+#define ORDER_NOT_FREE 0xFF
+
+size_t BuddyAllocator::MetadataSize(size_t frames)
+{
+    return frames * (sizeof(buddy_link_t) + sizeof(uint8_t));
+}
+
+size_t BuddyAllocator::OrderForCount(size_t count)
+{
+    size_t order = 0;
+    while (((size_t)1 << order) < count) {
+        order++;
+    }
+    return order;
+}
+
+BuddyAllocator::BuddyAllocator()
+    : links(NULL)
+    , orders(NULL)
+    , frameCount(0)
+    , freeFrames(0)
+{
+    for (size_t i = 0; i < BUDDY_ORDERS; i++) {
+        heads[i] = BUDDY_NONE;
+        counts[i] = 0;
+    }
+}
+
+BuddyAllocator::BuddyAllocator(void* buf, size_t frames)
+    : BuddyAllocator()
+{
+    // The links come first so that they stay naturally aligned
+    links = (buddy_link_t*)buf;
+    orders = (uint8_t*)(links + frames);
+    frameCount = frames;
+    // Nothing is free until a region is added
+    for (size_t i = 0; i < frames; i++) {
+        links[i] = { .next = BUDDY_NONE, .prev = BUDDY_NONE };
+        orders[i] = ORDER_NOT_FREE;
+    }
+}
+
+void BuddyAllocator::Push(size_t frame, size_t order)
+{
+    links[frame].prev = BUDDY_NONE;
+    links[frame].next = heads[order];
+    if (heads[order] != BUDDY_NONE) {
+        links[heads[order]].prev = (uint32_t)frame;
+    }
+    heads[order] = (uint32_t)frame;
+    orders[frame] = (uint8_t)order;
+    counts[order]++;
+}
+
+void BuddyAllocator::Unlink(size_t frame, size_t order)
+{
+    buddy_link_t* link = &links[frame];
+    if (link->prev != BUDDY_NONE) {
+        links[link->prev].next = link->next;
+    } else {
+        heads[order] = link->next;
+    }
+    if (link->next != BUDDY_NONE) {
+        links[link->next].prev = link->prev;
+    }
+    *link = { .next = BUDDY_NONE, .prev = BUDDY_NONE };
+    orders[frame] = ORDER_NOT_FREE;
+    counts[order]--;
+}
+
+size_t BuddyAllocator::Alloc(size_t order)
+{
+    if (order > BUDDY_MAX_ORDER) {
+        return SIZE_MAX;
+    }
+    // Find the smallest free block that is large enough
+    size_t current = order;
+    while (current <= BUDDY_MAX_ORDER && heads[current] == BUDDY_NONE) {
+        current++;
+    }
+    if (current > BUDDY_MAX_ORDER) {
+        return SIZE_MAX;
+    }
+    size_t frame = heads[current];
+    Unlink(frame, current);
+    // Split the block, handing the upper halves back to the free lists
+    while (current > order) {
+        current--;
+        Push(frame + ((size_t)1 << current), current);
+    }
+    freeFrames -= (size_t)1 << order;
+    return frame;
+}
+
+void BuddyAllocator::Free(size_t frame, size_t order)
+{
+    if (frame >= frameCount || order > BUDDY_MAX_ORDER) {
+        PANIC("Attempted to free an invalid buddy block.\n");
+    }
+    if (orders[frame] != ORDER_NOT_FREE) {
+        PANIC("Attempted to free a buddy block twice.\n");
+    }
+    freeFrames += (size_t)1 << order;
+    // Merge with the buddy for as long as it is free and the same size
+    while (order < BUDDY_MAX_ORDER) {
+        size_t buddy = frame ^ ((size_t)1 << order);
+        if (buddy >= frameCount || orders[buddy] != order) {
+            break;
+        }
+        Unlink(buddy, order);
+        frame &= ~((size_t)1 << order);
+        order++;
+    }
+    Push(frame, order);
+}
+
+void BuddyAllocator::FreeRange(size_t frame, size_t count)
+{
+    // Break the range into the largest naturally aligned blocks possible
+    while (count > 0) {
+        size_t order = BUDDY_MAX_ORDER;
+        while ((frame & (((size_t)1 << order) - 1)) || ((size_t)1 << order) > count) {
+            order--;
+        }
+        Free(frame, order);
+        frame += (size_t)1 << order;
+        count -= (size_t)1 << order;
+    }
+}
+
+void BuddyAllocator::AddRegion(size_t frame, size_t count)
+{
+    // Ignore anything that falls outside of the tracked frames
+    if (frame >= frameCount) {
+        return;
+    }
+    if (count > frameCount - frame) {
+        count = frameCount - frame;
+    }
+    FreeRange(frame, count);
+}
+
+size_t BuddyAllocator::AllocContiguous(size_t count)
+{
+    if (count == 0) {
+        return SIZE_MAX;
+    }
+    size_t order = OrderForCount(count);
+    size_t frame = Alloc(order);
+    if (frame == SIZE_MAX) {
+        return SIZE_MAX;
+    }
+    // Give back the part of the block that wasn't asked for
+    size_t unused = ((size_t)1 << order) - count;
+    if (unused) {
+        FreeRange(frame + count, unused);
+    }
+    return frame;
+}
+
+void BuddyAllocator::FreeContiguous(size_t frame, size_t count)
+{
+    FreeRange(frame, count);
+}
@@ -0,0 +1,108 @@
+/**
+ * @file buddy.hpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Binary buddy allocator used to manage physical frames
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <meta/compiler.hpp>
+
+// Largest block handed out by the allocator is 2^10 frames (4 MiB)
+#define BUDDY_MAX_ORDER 10
+#define BUDDY_ORDERS    (BUDDY_MAX_ORDER + 1)
+// Marks the end of a free list (and a frame that is not a free block head)
+#define BUDDY_NONE      UINT32_MAX
+
+/**
+ * @brief A binary buddy allocator which hands out blocks of 2^order frames.
+ * The allocator does not touch the memory it manages. All bookkeeping is
+ * kept in a caller-provided metadata buffer (see MetadataSize()) which holds
+ * a doubly linked free-list node and an order byte for every frame. Allocation
+ * and freeing walk at most BUDDY_ORDERS levels, splitting and coalescing
+ * blocks as they go.
+ */
+class BuddyAllocator {
+public:
+    /**
+     * @brief Computes the size of the metadata buffer needed to
+     * track a given number of frames.
+     *
+     * @param frames Number of frames to be tracked
+     * @return size_t Size of the metadata buffer in bytes
+     */
+    static size_t MetadataSize(size_t frames);
+    /**
+     * @brief Returns the smallest order whose block holds at least count frames.
+     *
+     * @param count Number of frames
+     * @return size_t Block order
+     */
+    static size_t OrderForCount(size_t count);
+
+    BuddyAllocator();
+    BuddyAllocator(void* buf, size_t frames);
+    /**
+     * @brief Hands a range of frames over to the allocator. Every frame
+     * in the range becomes free and is merged with its free buddies.
+     *
+     * @param frame First frame of the region
+     * @param count Number of frames in the region
+     */
+    void AddRegion(size_t frame, size_t count);
+    /**
+     * @brief Allocates a naturally aligned block of 2^order frames.
+     *
+     * @param order Block order (0 to BUDDY_MAX_ORDER)
+     * @return size_t First frame of the block or SIZE_MAX if none is available
+     */
+    size_t Alloc(size_t order);
+    /**
+     * @brief Returns a block previously obtained from Alloc().
+     *
+     * @param frame First frame of the block
+     * @param order Block order used to allocate the block
+     */
+    void Free(size_t frame, size_t order);
+    /**
+     * @brief Allocates count physically contiguous frames. The unused
+     * tail of the underlying power-of-two block is returned immediately.
+     *
+     * @param count Number of frames (at most 2^BUDDY_MAX_ORDER)
+     * @return size_t First frame of the run or SIZE_MAX if none is available
+     */
+    size_t AllocContiguous(size_t count);
+    /**
+     * @brief Returns a run previously obtained from AllocContiguous().
+     *
+     * @param frame First frame of the run
+     * @param count Number of frames in the run
+     */
+    void FreeContiguous(size_t frame, size_t count);
+    ALWAYS_INLINE size_t Frames() { return frameCount; }
+    ALWAYS_INLINE size_t FreeFrames() { return freeFrames; }
+    ALWAYS_INLINE size_t FreeBlocks(size_t order) { return counts[order]; }
+
+private:
+    typedef struct buddy_link {
+        uint32_t next;
+        uint32_t prev;
+    } buddy_link_t;
+
+    buddy_link_t* links;
+    uint8_t* orders;
+    size_t frameCount;
+    size_t freeFrames;
+    uint32_t heads[BUDDY_ORDERS];
+    size_t counts[BUDDY_ORDERS];
+
+    void Push(size_t frame, size_t order);
+    void Unlink(size_t frame, size_t order);
+    void FreeRange(size_t frame, size_t count);
+};
@@ -0,0 +1,367 @@
+/**
+ * @file frames.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Physical frame allocator seeded from the bootloader memory map
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <mem/frames.hpp>
+#include <mem/buddy.hpp>
+#include <mem/paging.hpp>
+#include <sys/panic.hpp>
+#include <lib/stdio.hpp>
+#include <dev/tty/tty.hpp>
+#include <dev/serial/rs232.hpp>
+
+// Maximum number of physical ranges kept out of the allocator
+#define FRAMES_RESERVED_MAX (8 + HANDOFF_MODULES_MAX)
+// Everything below 1 MiB belongs to the BIOS and legacy devices
+#define FRAMES_LOW_MEMORY   0x100000
+// Frames from here on need PAE page tables and cannot go into CR3
+#define FRAMES_HIGH_MEMORY  0x100000000ULL
+// Zones frames are handed out from, the high zone is empty without PAE
+#define FRAME_ZONE_LOW      0
+#define FRAME_ZONE_HIGH     1
+#define FRAME_ZONES         2
+
+typedef struct frame_range {
+    uint64_t start;
+    uint64_t end;
+} frame_range_t;
+
+typedef struct frame_zone {
+    BuddyAllocator allocator;   // Indexed from the first frame of the zone
+    size_t first;               // First frame of the zone
+    size_t count;               // Frames the zone spans
+} frame_zone_t;
+
+static frame_zone_t zones[FRAME_ZONES];
+static frame_range_t reserved[FRAMES_RESERVED_MAX];
+static size_t reserved_count = 0;
+static size_t usable_frames = 0;
+static frame_desc_t *descs = NULL;
+static size_t desc_count = 0;
+
+// Function prototypes
+static void frames_reserve(uint64_t start, uint64_t end);
+static void frames_add_usable(uint64_t start, uint64_t end, size_t first_reserved);
+static uint64_t frames_place_metadata(Boot::Handoff& handoff, size_t size);
+static void frames_reset(size_t first, size_t count, uint16_t refs, uint8_t flags);
+static frame_zone_t *frames_zone(size_t frame);
+static size_t frames_take(size_t count, size_t top_zone);
+static inline size_t frames_irq_save();
+static inline void frames_irq_restore(size_t flags);
+
+// The allocator is only ever touched with interrupts off rather than under
+// a mutex, so it can't be held by a preempted task and the page fault task
+// may allocate frames as well
+static inline size_t frames_irq_save()
+{
+    size_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r"(flags) :: "memory");
+    return flags;
+}
+
+static inline void frames_irq_restore(size_t flags)
+{
+    asm volatile("push %0; popf" :: "r"(flags) : "memory", "cc");
+}
+
+static void frames_reserve(uint64_t start, uint64_t end)
+{
+    if (reserved_count >= FRAMES_RESERVED_MAX) {
+        PANIC("Too many reserved physical ranges.\n");
+    }
+    // Round outwards so partially used frames stay reserved
+    reserved[reserved_count++] = {
+        .start = start & ~((uint64_t)PAGE_SIZE - 1),
+        .end = (end + PAGE_SIZE - 1) & ~((uint64_t)PAGE_SIZE - 1)
+    };
+}
+
+// Called with interrupts off (or before anything else runs)
+static void frames_reset(size_t first, size_t count, uint16_t refs, uint8_t flags)
+{
+    for (size_t i = first; i < first + count; i++) {
+        descs[i] = {
+            .refs = refs,
+            .flags = flags,
+            .owner = FRAME_OWNER_NONE,
+            .next = FRAME_NONE,
+            .prev = FRAME_NONE,
+            .priv = 0
+        };
+    }
+}
+
+static void frames_add_usable(uint64_t start, uint64_t end, size_t first_reserved)
+{
+    // Cut every reserved range out of [start, end) before handing it over.
+    // Ranges before first_reserved are already known not to overlap.
+    for (size_t i = first_reserved; i < reserved_count && start < end; i++) {
+        if (start < reserved[i].end && reserved[i].start < end) {
+            if (start < reserved[i].start) {
+                frames_add_usable(start, reserved[i].start, i + 1);
+            }
+            start = reserved[i].end;
+        }
+    }
+    if (start < end) {
+        size_t first = PHYS_TO_FRAME(start);
+        size_t count = PHYS_TO_FRAME(end - start);
+        // A region may straddle the zones
+        for (size_t z = 0; z < FRAME_ZONES; z++) {
+            size_t from = first > zones[z].first ? first : zones[z].first;
+            size_t to = first + count < zones[z].first + zones[z].count ? first + count : zones[z].first + zones[z].count;
+            if (from < to) {
+                zones[z].allocator.AddRegion(from - zones[z].first, to - from);
+            }
+        }
+        frames_reset(first, count, 0, 0);
+        usable_frames += count;
+    }
+}
+
+static frame_zone_t *frames_zone(size_t frame)
+{
+    return frame >= zones[FRAME_ZONE_HIGH].first ? &zones[FRAME_ZONE_HIGH] : &zones[FRAME_ZONE_LOW];
+}
+
+// Called with interrupts off, tries the zones from top_zone down
+static size_t frames_take(size_t count, size_t top_zone)
+{
+    for (size_t z = top_zone + 1; z-- > 0;) {
+        frame_zone_t *zone = &zones[z];
+        size_t frame = count == 1 ? zone->allocator.Alloc(0) : zone->allocator.AllocContiguous(count);
+        if (frame != SIZE_MAX) {
+            frame += zone->first;
+            frames_reset(frame, count, 1, 0);
+            return frame;
+        }
+    }
+    return SIZE_MAX;
+}
+
+static uint64_t frames_place_metadata(Boot::Handoff& handoff, size_t size)
+{
+    for (size_t i = 0; i < handoff.getMemoryMapCount(); i++) {
+        auto region = handoff.getMemoryRegion(i);
+        if (region.getType() != Boot::MemoryUsable) continue;
+        // The metadata is identity mapped, so it has to sit below the higher half
+        uint64_t start = (region.getBase() + PAGE_SIZE - 1) & ~((uint64_t)PAGE_SIZE - 1);
+        uint64_t end = region.getBase() + region.getLength();
+        if (end > KERNEL_BASE) end = KERNEL_BASE;
+        // Slide past anything that is already spoken for
+        bool moved;
+        do {
+            moved = false;
+            for (size_t r = 0; r < reserved_count; r++) {
+                if (start < reserved[r].end && reserved[r].start < start + size) {
+                    start = reserved[r].end;
+                    moved = true;
+                }
+            }
+        } while (moved);
+        if (start + size <= end) {
+            return start;
+        }
+    }
+    return 0;
+}
+
+void frames_init(Boot::Handoff& handoff)
+{
+    // Find the end of usable memory that we are able to address
+    uint64_t phys_end = 0;
+    for (size_t i = 0; i < handoff.getMemoryMapCount(); i++) {
+        auto region = handoff.getMemoryRegion(i);
+        if (region.getType() != Boot::MemoryUsable) continue;
+        uint64_t end = region.getBase() + region.getLength();
+        if (end > PHYS_ADDRESS_LIMIT) end = PHYS_ADDRESS_LIMIT;
+        if (end > phys_end) phys_end = end;
+    }
+    size_t frame_count = PHYS_TO_FRAME(phys_end);
+    if (frame_count == 0) {
+        PANIC("Bootloader did not provide any usable memory.\n");
+    }
+    // Keep the BIOS area, the kernel image, and the boot information
+    frames_reserve(0, FRAMES_LOW_MEMORY);
+    frames_reserve(FRAMES_LOW_MEMORY, KADDR_TO_PHYS(KERNEL_END));
+    if (handoff.getHandleSize()) {
+        uintptr_t handle = (uintptr_t)handoff.getHandle();
+        frames_reserve(handle, handle + handoff.getHandleSize());
+    }
+    // Modules are used in place, wherever the bootloader loaded them
+    for (size_t i = 0; i < handoff.getModuleCount(); i++) {
+        auto module = handoff.getModule(i);
+        frames_reserve(module.getBase(), module.getBase() + module.getLength());
+    }
+    // Carve the descriptors and the allocator metadata out of usable
+    // memory and map them in
+    size_t low_count = phys_end > FRAMES_HIGH_MEMORY ? PHYS_TO_FRAME(FRAMES_HIGH_MEMORY) : frame_count;
+    size_t desc_size = frame_count * sizeof(frame_desc_t);
+    // Keep the high zone metadata as aligned as the low zone metadata
+    size_t low_size = (BuddyAllocator::MetadataSize(low_count) + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+    size_t meta_size = PAGE_ALIGN_UP(desc_size + low_size + BuddyAllocator::MetadataSize(frame_count - low_count));
+    uint64_t meta = frames_place_metadata(handoff, meta_size);
+    if (meta == 0) {
+        PANIC("Unable to find room for the frame allocator metadata.\n");
+    }
+    frames_reserve(meta, meta + meta_size);
+    map_kernel_range((uintptr_t)meta, (uint32_t)meta, meta_size);
+    descs = (frame_desc_t *)(uintptr_t)meta;
+    desc_count = frame_count;
+    zones[FRAME_ZONE_LOW] = {
+        .allocator = BuddyAllocator((void*)(uintptr_t)(meta + desc_size), low_count),
+        .first = 0,
+        .count = low_count
+    };
+    zones[FRAME_ZONE_HIGH] = {
+        .allocator = BuddyAllocator((void*)(uintptr_t)(meta + desc_size + low_size), frame_count - low_count),
+        .first = low_count,
+        .count = frame_count - low_count
+    };
+    // Whatever is not handed to the allocator below stays pinned
+    frames_reset(0, frame_count, 1, FRAME_PINNED);
+    // Hand every usable region to the allocator
+    for (size_t i = 0; i < handoff.getMemoryMapCount(); i++) {
+        auto region = handoff.getMemoryRegion(i);
+        if (region.getType() != Boot::MemoryUsable) continue;
+        uint64_t start = (region.getBase() + PAGE_SIZE - 1) & ~((uint64_t)PAGE_SIZE - 1);
+        uint64_t end = (region.getBase() + region.getLength()) & ~((uint64_t)PAGE_SIZE - 1);
+        if (end > phys_end) end = phys_end;
+        if (start < end) {
+            frames_add_usable(start, end, 0);
+        }
+    }
+    rs232::printf("Frame allocator: %u frames tracked, %u free (%u above 4 GiB), descriptors and metadata at 0x%08x (%u KiB)\n",
+        frame_count, frames_free_count(), zones[FRAME_ZONE_HIGH].allocator.FreeFrames(), (uint32_t)meta, meta_size / 1024);
+    kprintf(DBG_INFO "%u MiB of physical memory available\n", frames_free_count() / (1024 * 1024 / PAGE_SIZE));
+}
+
+size_t frames_alloc()
+{
+    // High frames go first so that low ones are left for whoever needs them
+    size_t flags = frames_irq_save();
+    size_t frame = frames_take(1, FRAME_ZONE_HIGH);
+    frames_irq_restore(flags);
+    return frame;
+}
+
+size_t frames_alloc_low()
+{
+    size_t flags = frames_irq_save();
+    size_t frame = frames_take(1, FRAME_ZONE_LOW);
+    frames_irq_restore(flags);
+    return frame;
+}
+
+size_t frames_alloc_contiguous(size_t count)
+{
+    size_t flags = frames_irq_save();
+    size_t frame = frames_take(count, FRAME_ZONE_HIGH);
+    frames_irq_restore(flags);
+    return frame;
+}
+
+void frames_free(size_t frame)
+{
+    size_t flags = frames_irq_save();
+    frame_zone_t *zone = frames_zone(frame);
+    zone->allocator.Free(frame - zone->first, 0);
+    frames_reset(frame, 1, 0, 0);
+    frames_irq_restore(flags);
+}
+
+void frames_free_contiguous(size_t frame, size_t count)
+{
+    size_t flags = frames_irq_save();
+    frame_zone_t *zone = frames_zone(frame);
+    zone->allocator.FreeContiguous(frame - zone->first, count);
+    frames_reset(frame, count, 0, 0);
+    frames_irq_restore(flags);
+}
+
+frame_desc_t *frame_desc(size_t frame)
+{
+    return frame < desc_count ? &descs[frame] : NULL;
+}
+
+bool frame_share(size_t frame)
+{
+    frame_desc_t *desc = frame_desc(frame);
+    if (desc == NULL) {
+        return false;
+    }
+    uint16_t refs = __atomic_load_n(&desc->refs, __ATOMIC_RELAXED);
+    do {
+        if (refs == 0 || refs == UINT16_MAX) {
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&desc->refs, &refs, refs + 1, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return true;
+}
+
+bool frame_unshare(size_t frame)
+{
+    frame_desc_t *desc = frame_desc(frame);
+    if (desc == NULL) {
+        return false;
+    }
+    uint16_t refs = __atomic_load_n(&desc->refs, __ATOMIC_RELAXED);
+    do {
+        if (refs <= 1) {
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&desc->refs, &refs, refs - 1, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return true;
+}
+
+void frame_set_flags(size_t frame, uint8_t flags)
+{
+    frame_desc_t *desc = frame_desc(frame);
+    if (desc != NULL) {
+        __atomic_or_fetch(&desc->flags, flags, __ATOMIC_RELAXED);
+    }
+}
+
+void frame_clear_flags(size_t frame, uint8_t flags)
+{
+    frame_desc_t *desc = frame_desc(frame);
+    if (desc != NULL) {
+        __atomic_and_fetch(&desc->flags, (uint8_t)~flags, __ATOMIC_RELAXED);
+    }
+}
+
+size_t frames_free_count()
+{
+    return zones[FRAME_ZONE_LOW].allocator.FreeFrames() + zones[FRAME_ZONE_HIGH].allocator.FreeFrames();
+}
+
+void frames_get_stats(frames_stats_t *stats)
+{
+    size_t flags = frames_irq_save();
+    stats->usable = usable_frames;
+    stats->free = frames_free_count();
+    stats->high_free = zones[FRAME_ZONE_HIGH].allocator.FreeFrames();
+    stats->reserved = desc_count - usable_frames;
+    // Buddies of the same order are never both free, so the largest
+    // block is a good measure of the largest run that can be allocated
+    stats->largest_free = 0;
+    for (size_t z = 0; z < FRAME_ZONES; z++) {
+        for (size_t order = BUDDY_ORDERS; order-- > 0;) {
+            if (zones[z].allocator.FreeBlocks(order)) {
+                if (((size_t)1 << order) > stats->largest_free) {
+                    stats->largest_free = (size_t)1 << order;
+                }
+                break;
+            }
+        }
+    }
+    frames_irq_restore(flags);
+}
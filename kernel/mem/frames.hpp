@@ -0,0 +1,164 @@
+/**
+ * @file frames.hpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Physical frame allocator seeded from the bootloader memory map
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mem/paging.hpp>
+#include <boot/Handoff.hpp>
+
+#define FRAME_TO_PHYS(frame) ((phys_addr_t)(frame) * PAGE_SIZE)
+#define PHYS_TO_FRAME(addr)  ((addr) / PAGE_SIZE)
+
+// Frame descriptor flags
+#define FRAME_ZEROED        0x1     // Known to hold nothing but zeroes
+#define FRAME_PINNED        0x2     // Never handed out (firmware, kernel image, holes)
+#define FRAME_SLAB          0x4     // Holds a slab
+#define FRAME_PAGE_TABLE    0x8     // Holds a page table or directory
+// Ends the owner and LRU lists, and marks frames nobody claimed
+#define FRAME_NONE          UINT32_MAX
+#define FRAME_OWNER_NONE    0xFF
+
+/**
+ * @brief Per-frame metadata. One descriptor exists for every frame up to
+ * the end of usable memory and they are kept together with the allocator
+ * metadata, so looking one up is an index into an array. Allocating and
+ * freeing frames resets them, everything else is up to the owner.
+ */
+typedef struct frame_descriptor {
+    uint16_t refs;          // Users of the frame (mappings sharing it), 0 while free
+    uint8_t flags;          // FRAME_* flags
+    uint8_t owner;          // mem_owner_t the frame is counted under, or FRAME_OWNER_NONE
+    uint32_t next;          // Owner or LRU list links (frame numbers, FRAME_NONE ends them)
+    uint32_t prev;
+    uint32_t priv;          // Left to the owner
+} frame_desc_t;
+
+static_assert(sizeof(frame_desc_t) == 16, "Frame descriptors should stay four to a cache line");
+
+typedef struct frames_stats {
+    size_t usable;          // Frames handed to the allocator at boot
+    size_t free;            // Frames currently free
+    size_t reserved;        // Tracked frames that are not usable (firmware, kernel, holes)
+    size_t largest_free;    // Frames in the largest free block
+    size_t high_free;       // Free frames above 4 GiB (only with PAE)
+} frames_stats_t;
+
+/**
+ * @brief Builds the physical frame allocator from the memory map provided
+ * by the bootloader. Only usable memory is handed out. The low 1 MiB, the
+ * kernel image and the boot information are kept reserved. Memory above
+ * 4 GiB is only used with PAE (up to PHYS_ADDRESS_LIMIT) and goes into a
+ * zone of its own.
+ *
+ * @param handoff Parsed bootloader information
+ */
+void frames_init(Boot::Handoff& handoff);
+
+/**
+ * @brief Allocates a single physical frame. Frames above 4 GiB are handed
+ * out first, so the frame can only be reached through a mapping. Never
+ * blocks, the page fault task may use it too.
+ *
+ * @return size_t Frame number or SIZE_MAX if out of memory
+ */
+size_t frames_alloc();
+
+/**
+ * @brief Allocates a single physical frame below 4 GiB, for structures
+ * whose physical address has to fit in 32 bits (e.g. what CR3 points at).
+ *
+ * @return size_t Frame number or SIZE_MAX if out of low memory
+ */
+size_t frames_alloc_low();
+
+/**
+ * @brief Allocates a run of physically contiguous frames. Runs are limited
+ * to the largest buddy block (2^BUDDY_MAX_ORDER frames).
+ *
+ * @param count Number of frames
+ * @return size_t First frame number or SIZE_MAX if no run is available
+ */
+size_t frames_alloc_contiguous(size_t count);
+
+/**
+ * @brief Frees a single physical frame.
+ *
+ * @param frame Frame number returned by frames_alloc()
+ */
+void frames_free(size_t frame);
+
+/**
+ * @brief Frees a run of physically contiguous frames.
+ *
+ * @param frame First frame number returned by frames_alloc_contiguous()
+ * @param count Number of frames in the run
+ */
+void frames_free_contiguous(size_t frame, size_t count);
+
+/**
+ * @brief Looks up the descriptor of a frame.
+ *
+ * @param frame Frame number
+ * @return frame_desc_t* Descriptor or NULL if the frame is not tracked
+ */
+frame_desc_t *frame_desc(size_t frame);
+
+/**
+ * @brief Adds a user to an allocated frame. Lock free, so it may be used
+ * from the page fault task.
+ *
+ * @param frame Frame number
+ * @return true The frame has one more user
+ * @return false The frame is untracked, free or has too many users
+ */
+bool frame_share(size_t frame);
+
+/**
+ * @brief Drops one of several users of a frame. The last user keeps its
+ * reference and gives the frame back with frames_free() instead. Lock
+ * free, so it may be used from the page fault task.
+ *
+ * @param frame Frame number
+ * @return true Another user still holds the frame
+ * @return false The caller was the only user, nothing was changed
+ */
+bool frame_unshare(size_t frame);
+
+/**
+ * @brief Sets flags in the descriptor of a frame. Untracked frames are ignored.
+ *
+ * @param frame Frame number
+ * @param flags FRAME_* flags to set
+ */
+void frame_set_flags(size_t frame, uint8_t flags);
+
+/**
+ * @brief Clears flags in the descriptor of a frame. Untracked frames are ignored.
+ *
+ * @param frame Frame number
+ * @param flags FRAME_* flags to clear
+ */
+void frame_clear_flags(size_t frame, uint8_t flags);
+
+/**
+ * @brief Returns the number of frames that are currently free.
+ *
+ * @return size_t Free frame count
+ */
+size_t frames_free_count();
+
+/**
+ * @brief Fills in the physical memory usage.
+ *
+ * @param stats Statistics to be filled in
+ */
+void frames_get_stats(frames_stats_t *stats);
@@ -15,6 +15,112 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The kernel heap is provided either by liballoc or by the TLSF allocator,
+ * selected at build time with HEAP=liballoc or HEAP=tlsf (the default).
+ */
+
+typedef struct heap_stats {
+    size_t pool;            // Bytes handed to the heap by the paging code
+    size_t free;            // Bytes available for allocation
+    size_t largest_free;    // Largest single allocation that fits without growing
+    size_t free_blocks;     // Number of free blocks the free bytes are split into
+} heap_stats_t;
+
+/**
+ * @brief Fills in the current heap usage. Allocators that cannot tell
+ * how their pools are used only report the pool size.
+ *
+ * @param stats Statistics to be filled in
+ */
+void heap_get_stats(heap_stats_t *stats);
+
+/**
+ * @brief Prints the heap usage over serial.
+ *
+ */
+void heap_print_stats();
+
+// Call sites and live allocations tracked while profiling
+#define HEAP_PROFILE_SITES      256
+#define HEAP_PROFILE_LIVE       8192
+// Power of two size classes from 16 bytes up, the last one takes the rest
+#define HEAP_PROFILE_CLASSES    12
+// Sites printed by heap_profile_print()
+#define HEAP_PROFILE_TOP        10
+
+typedef struct heap_site {
+    uintptr_t caller;       // Return address into the caller (0 once the table is full)
+    size_t allocs;          // Allocations made since profiling started
+    size_t frees;           // Allocations given back since profiling started
+    size_t live_bytes;      // Bytes currently allocated
+    size_t peak_bytes;      // Highest live_bytes seen
+    uint64_t total_bytes;   // Bytes ever allocated
+    uint32_t classes[HEAP_PROFILE_CLASSES]; // Allocations per size class
+} heap_site_t;
+
+// Only ever changed by heap_profile_start() and heap_profile_stop()
+extern bool heap_profile_active;
+
+/**
+ * @brief Starts recording every heap allocation by call site. Previous
+ * results are thrown away. The tables come from the paging code, nothing
+ * is taken from the heap being profiled.
+ *
+ * @return true Profiling is on
+ * @return false The tables could not be allocated
+ */
+bool heap_profile_start();
+
+/**
+ * @brief Stops recording and frees the tables.
+ *
+ */
+void heap_profile_stop();
+
+/**
+ * @brief Copies the sites holding the most live memory.
+ *
+ * @param sites Receives up to count sites, largest first
+ * @param count Number of entries in sites
+ * @return size_t Number of sites copied
+ */
+size_t heap_profile_top(heap_site_t *sites, size_t count);
+
+/**
+ * @brief Prints the top HEAP_PROFILE_TOP sites over serial. Each line
+ * starts with "heap-site <caller>" so that `make symbolize` can resolve
+ * the addresses against the kernel symbols on the host.
+ *
+ */
+void heap_profile_print();
+
+void heap_profile_record_alloc(void *ptr, size_t size, void *caller);
+void heap_profile_record_free(void *ptr);
+
+/**
+ * @brief Called by the allocator with its lock held after handing out
+ * memory. Costs a single branch unless profiling is on.
+ */
+static inline void heap_profile_alloc(void *ptr, size_t size, void *caller)
+{
+    if (__builtin_expect(heap_profile_active, false)) {
+        heap_profile_record_alloc(ptr, size, caller);
+    }
+}
+
+/**
+ * @brief Called by the allocator with its lock held before memory is
+ * given back. Costs a single branch unless profiling is on.
+ */
+static inline void heap_profile_free(void *ptr)
+{
+    if (__builtin_expect(heap_profile_active, false)) {
+        heap_profile_record_free(ptr);
+    }
+}
 
 extern "C"
 {
@@ -58,8 +164,15 @@ void* liballoc_alloc(unsigned int);
  */
 int liballoc_free(void*, unsigned int);
 
+#ifndef TESTING
 extern void     *malloc(size_t);
 extern void     *realloc(void *, size_t);
 extern void     *calloc(size_t, size_t);
 extern void      free(void *);
+#endif
 }
+
+#ifdef TESTING
+// Unit tests run on top of the host's C library
+#include <stdlib.h>
+#endif
@@ -0,0 +1,223 @@
+/**
+ * @file heap_profile.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Heap allocation profiler keyed by call site
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <mem/heap.hpp>
+#include <mem/paging.hpp>
+#include <lib/mutex.hpp>
+#include <arch/i386/timer.hpp>
+#include <dev/serial/rs232.hpp>
+
+#define HEAP_PROFILE_BYTES  (sizeof(heap_site_t) * HEAP_PROFILE_SITES + sizeof(heap_live_t) * HEAP_PROFILE_LIVE)
+
+typedef struct heap_live {
+    uintptr_t ptr;          // 0 for an empty slot
+    uint32_t size;
+    uint32_t site;
+} heap_live_t;
+
+bool heap_profile_active = false;
+static mutex_t lock("heap_profile");
+static heap_site_t *sites = NULL;
+static heap_live_t *live = NULL;
+static size_t live_used = 0;
+static size_t untracked = 0;
+static uint32_t start_tick = 0;
+
+// Function prototypes
+static inline size_t heap_profile_hash(uintptr_t key, size_t size);
+static inline size_t heap_profile_class(size_t size);
+static heap_site_t *heap_profile_site(uintptr_t caller);
+static heap_live_t *heap_profile_live(uintptr_t ptr);
+static void heap_profile_remove(heap_live_t *entry);
+
+static inline size_t heap_profile_hash(uintptr_t key, size_t size)
+{
+    // Heap pointers and return addresses both have boring low bits
+    return ((uint32_t)key * 2654435761u >> 8) & (size - 1);
+}
+
+static inline size_t heap_profile_class(size_t size)
+{
+    if (size <= 16) {
+        return 0;
+    }
+    size_t cls = (sizeof(unsigned long) * 8 - __builtin_clzl(size - 1)) - 4;
+    return cls < HEAP_PROFILE_CLASSES ? cls : HEAP_PROFILE_CLASSES - 1;
+}
+
+static heap_site_t *heap_profile_site(uintptr_t caller)
+{
+    // Slot 0 collects everything once the table is full
+    size_t slot = heap_profile_hash(caller, HEAP_PROFILE_SITES);
+    for (size_t i = 0; i < HEAP_PROFILE_SITES - 1; i++) {
+        if (slot == 0) slot = 1;
+        if (sites[slot].caller == caller) {
+            return &sites[slot];
+        }
+        if (sites[slot].caller == 0) {
+            sites[slot].caller = caller;
+            return &sites[slot];
+        }
+        slot = (slot + 1) & (HEAP_PROFILE_SITES - 1);
+    }
+    return &sites[0];
+}
+
+static heap_live_t *heap_profile_live(uintptr_t ptr)
+{
+    size_t slot = heap_profile_hash(ptr, HEAP_PROFILE_LIVE);
+    while (live[slot].ptr != 0 && live[slot].ptr != ptr) {
+        slot = (slot + 1) & (HEAP_PROFILE_LIVE - 1);
+    }
+    return &live[slot];
+}
+
+static void heap_profile_remove(heap_live_t *entry)
+{
+    // Backward shift deletion keeps every probe sequence unbroken
+    size_t hole = entry - live;
+    for (size_t next = (hole + 1) & (HEAP_PROFILE_LIVE - 1); live[next].ptr != 0;
+         next = (next + 1) & (HEAP_PROFILE_LIVE - 1)) {
+        size_t home = heap_profile_hash(live[next].ptr, HEAP_PROFILE_LIVE);
+        if (((next - home) & (HEAP_PROFILE_LIVE - 1)) >= ((next - hole) & (HEAP_PROFILE_LIVE - 1))) {
+            live[hole] = live[next];
+            hole = next;
+        }
+    }
+    live[hole].ptr = 0;
+    live_used--;
+}
+
+bool heap_profile_start()
+{
+    mutex_lock(&lock);
+    if (sites == NULL) {
+        void *tables = get_new_page(HEAP_PROFILE_BYTES - 1);
+        if (tables == NULL) {
+            mutex_unlock(&lock);
+            return false;
+        }
+        sites = (heap_site_t *)tables;
+        live = (heap_live_t *)(sites + HEAP_PROFILE_SITES);
+    }
+    __builtin_memset(sites, 0, HEAP_PROFILE_BYTES);
+    live_used = 0;
+    untracked = 0;
+    start_tick = timer_tick;
+    __atomic_store_n(&heap_profile_active, true, __ATOMIC_RELEASE);
+    mutex_unlock(&lock);
+    return true;
+}
+
+void heap_profile_stop()
+{
+    mutex_lock(&lock);
+    __atomic_store_n(&heap_profile_active, false, __ATOMIC_RELEASE);
+    if (sites != NULL) {
+        free_page(sites, HEAP_PROFILE_BYTES - 1);
+        sites = NULL;
+        live = NULL;
+    }
+    mutex_unlock(&lock);
+}
+
+void heap_profile_record_alloc(void *ptr, size_t size, void *caller)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    mutex_lock(&lock);
+    if (sites == NULL) {
+        mutex_unlock(&lock);
+        return;
+    }
+    heap_site_t *site = heap_profile_site((uintptr_t)caller);
+    site->allocs++;
+    site->total_bytes += size;
+    site->classes[heap_profile_class(size)]++;
+    // Frees can only be matched up with allocations that are remembered
+    if (live_used < HEAP_PROFILE_LIVE / 4 * 3) {
+        heap_live_t *entry = heap_profile_live((uintptr_t)ptr);
+        if (entry->ptr == 0) {
+            live_used++;
+        }
+        *entry = { .ptr = (uintptr_t)ptr, .size = (uint32_t)size, .site = (uint32_t)(site - sites) };
+        site->live_bytes += size;
+        if (site->live_bytes > site->peak_bytes) {
+            site->peak_bytes = site->live_bytes;
+        }
+    } else {
+        untracked++;
+    }
+    mutex_unlock(&lock);
+}
+
+void heap_profile_record_free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    mutex_lock(&lock);
+    if (sites == NULL) {
+        mutex_unlock(&lock);
+        return;
+    }
+    // Memory allocated before profiling started is not in the table
+    heap_live_t *entry = heap_profile_live((uintptr_t)ptr);
+    if (entry->ptr != 0) {
+        heap_site_t *site = &sites[entry->site];
+        site->frees++;
+        site->live_bytes -= entry->size;
+        heap_profile_remove(entry);
+    }
+    mutex_unlock(&lock);
+}
+
+size_t heap_profile_top(heap_site_t *top, size_t count)
+{
+    size_t found = 0;
+    mutex_lock(&lock);
+    for (size_t i = 0; sites != NULL && i < HEAP_PROFILE_SITES; i++) {
+        heap_site_t *site = &sites[i];
+        if (site->allocs == 0) continue;
+        // Insertion into a short sorted list
+        size_t pos = found < count ? found : count;
+        while (pos > 0 && (top[pos - 1].live_bytes < site->live_bytes ||
+               (top[pos - 1].live_bytes == site->live_bytes && top[pos - 1].allocs < site->allocs))) {
+            if (pos < count) top[pos] = top[pos - 1];
+            pos--;
+        }
+        if (pos < count) {
+            top[pos] = *site;
+            if (found < count) found++;
+        }
+    }
+    mutex_unlock(&lock);
+    return found;
+}
+
+void heap_profile_print()
+{
+    heap_site_t top[HEAP_PROFILE_TOP];
+    size_t count = heap_profile_top(top, HEAP_PROFILE_TOP);
+    uint32_t elapsed = timer_tick - start_tick;
+    if (elapsed == 0) elapsed = 1;
+    rs232::printf("heap profile: %u ms, %u allocations untracked\n", elapsed, untracked);
+    for (size_t i = 0; i < count; i++) {
+        heap_site_t *site = &top[i];
+        rs232::printf("heap-site 0x%08x live %u peak %u allocs %u frees %u rate %u/s\n  classes:",
+            site->caller, site->live_bytes, site->peak_bytes, site->allocs, site->frees,
+            (uint32_t)((uint64_t)site->allocs * 1000 / elapsed));
+        for (size_t c = 0; c < HEAP_PROFILE_CLASSES; c++) {
+            rs232::printf(" %u", site->classes[c]);
+        }
+        rs232::printf("\n");
+    }
+}
@@ -1,9 +1,27 @@
+#ifdef HEAP_LIBALLOC
+
+#include <mem/heap.hpp>
 #include <mem/paging.hpp>
+#include <mem/memstats.hpp>
 #include <lib/mutex.hpp>
 #include <lib/errno.h>
 #include <stddef.h>
+#include <dev/serial/rs232.hpp>
 
 static mutex_t lock("alloc");
+// liballoc keeps its bookkeeping to itself, so only the pages are known
+static size_t pool_pages = 0;
+
+void heap_get_stats(heap_stats_t *stats)
+{
+    *stats = { /* Zero */ };
+    stats->pool = pool_pages * PAGE_SIZE;
+}
+
+void heap_print_stats()
+{
+    rs232::printf("heap: %u bytes in pools\n", pool_pages * PAGE_SIZE);
+}
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,7 +54,12 @@ int liballoc_unlock()
  */
 void *liballoc_alloc(unsigned int count)
 {
-    return get_new_page(count * PAGE_SIZE - 1);
+    void *pages = get_new_page(count * PAGE_SIZE - 1);
+    if (pages != NULL) {
+        pool_pages += count;
+        mem_stats_add(MEM_OWNER_HEAP, count);
+    }
+    return pages;
 }
 
 /*
@@ -45,6 +68,8 @@ void *liballoc_alloc(unsigned int count)
 int liballoc_free(void *page, unsigned int count)
 {
     free_page(page, count * PAGE_SIZE - 1);
+    pool_pages -= count;
+    mem_stats_sub(MEM_OWNER_HEAP, count);
     return 0;
 }
 
@@ -52,3 +77,4 @@ int liballoc_free(void *page, unsigned int count)
 }
 #endif
 
+#endif /* HEAP_LIBALLOC */
@@ -0,0 +1,63 @@
+/**
+ * @file memstats.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Memory usage statistics
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <mem/memstats.hpp>
+#include <mem/paging.hpp>
+#include <dev/serial/rs232.hpp>
+
+#define KIB(pages) ((pages) * (PAGE_SIZE / 1024))
+
+size_t mem_owner_pages[MEM_OWNERS];
+
+static const char *mem_owner_names[MEM_OWNERS] = {
+    "heap",
+    "stacks",
+    "page tables",
+    "framebuffer",
+    "arenas",
+};
+
+void mem_get_stats(mem_stats_t *stats)
+{
+    frames_get_stats(&stats->frames);
+    for (size_t i = 0; i < MEM_OWNERS; i++) {
+        stats->owner_pages[i] = __atomic_load_n(&mem_owner_pages[i], __ATOMIC_RELAXED);
+    }
+    paging_get_arena_stats(&stats->virt_free, &stats->virt_largest_free);
+    heap_get_stats(&stats->heap);
+    stats->heap_fragmentation = 0;
+    if (stats->heap.free) {
+        stats->heap_fragmentation = 100 - (stats->heap.largest_free * 100) / stats->heap.free;
+    }
+    zero_pool_get_stats(&stats->zero_pool);
+    reclaim_get_stats(&stats->reclaim);
+}
+
+void mem_print_stats()
+{
+    mem_stats_t stats;
+    mem_get_stats(&stats);
+    size_t used = stats.frames.usable - stats.frames.free;
+    rs232::printf("frames: %u KiB usable, %u KiB used, %u KiB free, %u KiB reserved\n",
+        KIB(stats.frames.usable), KIB(used), KIB(stats.frames.free), KIB(stats.frames.reserved));
+    rs232::printf("frames: largest free run %u KiB, %u KiB free above 4 GiB\n",
+        KIB(stats.frames.largest_free), KIB(stats.frames.high_free));
+    for (size_t i = 0; i < MEM_OWNERS; i++) {
+        rs232::printf("  %-12s %8u KiB\n", mem_owner_names[i], KIB(stats.owner_pages[i]));
+    }
+    rs232::printf("virtual: %u KiB free, largest free range %u KiB\n",
+        stats.virt_free / 1024, stats.virt_largest_free / 1024);
+    rs232::printf("heap: %u bytes in pools, %u free in %u blocks, largest %u (%u%% fragmented)\n",
+        stats.heap.pool, stats.heap.free, stats.heap.free_blocks, stats.heap.largest_free,
+        stats.heap_fragmentation);
+    zero_pool_print_stats();
+    rs232::printf("reclaim: watermarks %u/%u frames, %u pages reclaimed in %u passes\n",
+        stats.reclaim.low, stats.reclaim.high, stats.reclaim.reclaimed, stats.reclaim.runs);
+}
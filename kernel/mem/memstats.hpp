@@ -0,0 +1,82 @@
+/**
+ * @file memstats.hpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Memory usage statistics
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mem/heap.hpp>
+#include <mem/frames.hpp>
+#include <mem/zero_pool.hpp>
+#include <mem/reclaim.hpp>
+
+/**
+ * @brief Subsystems whose page usage is counted.
+ *
+ */
+typedef enum mem_owner {
+    MEM_OWNER_HEAP,         // Pools handed to the kernel heap
+    MEM_OWNER_STACKS,       // Committed task stack pages
+    MEM_OWNER_PAGE_TABLES,  // Page directory and page tables
+    MEM_OWNER_FRAMEBUFFER,  // Framebuffer mapping
+    MEM_OWNER_ARENAS,       // Chunks held by arena allocators
+    MEM_OWNERS
+} mem_owner_t;
+
+typedef struct mem_stats {
+    frames_stats_t frames;          // Physical frames
+    size_t owner_pages[MEM_OWNERS]; // Pages used by each subsystem
+    size_t virt_free;               // Kernel address space left in bytes
+    size_t virt_largest_free;       // Largest free kernel address range in bytes
+    heap_stats_t heap;
+    size_t heap_fragmentation;      // Percentage of free heap bytes outside the largest block
+    zero_pool_stats_t zero_pool;
+    reclaim_stats_t reclaim;
+} mem_stats_t;
+
+// Only ever updated through mem_stats_add() and mem_stats_sub()
+extern size_t mem_owner_pages[MEM_OWNERS];
+
+/**
+ * @brief Counts pages as used by a subsystem. A single atomic add, so it is
+ * left on in release builds and safe to call from the page fault task.
+ *
+ * @param owner Subsystem using the pages
+ * @param pages Number of pages
+ */
+static inline void mem_stats_add(mem_owner_t owner, size_t pages)
+{
+    __atomic_add_fetch(&mem_owner_pages[owner], pages, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Counts pages as no longer used by a subsystem.
+ *
+ * @param owner Subsystem that used the pages
+ * @param pages Number of pages
+ */
+static inline void mem_stats_sub(mem_owner_t owner, size_t pages)
+{
+    __atomic_sub_fetch(&mem_owner_pages[owner], pages, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Gathers the statistics of every memory subsystem. This takes the
+ * subsystems' locks, so it must be called from a task.
+ *
+ * @param stats Statistics to be filled in
+ */
+void mem_get_stats(mem_stats_t *stats);
+
+/**
+ * @brief Prints the memory statistics over serial.
+ *
+ */
+void mem_print_stats();
@@ -12,65 +12,467 @@
 
 #include <sys/panic.hpp>
 #include <mem/paging.hpp>
-#include <lib/bitset.hpp>
+#include <mem/memstats.hpp>
+#include <mem/frames.hpp>
+#include <mem/slab.hpp>
+#include <mem/zero_pool.hpp>
+#include <mem/vmem.hpp>
+#include <mem/reclaim.hpp>
+#include <arch/i386/tss.hpp>
+#include <cpuid.h>
 #include <lib/stdio.hpp>
 #include <lib/mutex.hpp>
+#include <lib/string.hpp>
 #include <dev/serial/rs232.hpp>
 #include <stddef.h>
 
-#define KADDR_TO_PHYS(addr) ((addr) - KERNEL_BASE)
-
 static uint32_t machine_page_count;
+static bool paging_pse = false;
+static bool paging_pge = false;
+static bool paging_pat = false;
+static bool paging_active = false;
 static mutex_t mutex_paging("paging");
+static mutex_t mutex_spaces("address_space");
 
-#define MEM_BITMAP_SIZE ((ADDRESS_SPACE_SIZE / PAGE_SIZE) / (sizeof(size_t) * CHAR_BIT))
+// Kernel virtual addresses are handed out from above the kernel image up to the fixmap
+#define KERNEL_ARENA_END        FIXMAP_BASE
+// Temporary mappings of single frames sit right below the recursive mapping
+#define FIXMAP_BASE             (PAGING_RECURSIVE_TABLES - FIXMAP_SLOTS * PAGE_SIZE)
+#define FIXMAP_ALL              ((1U << FIXMAP_SLOTS) - 1)
+// Segment descriptors available before the heap is up, and the low water mark for refilling them
+#define ARENA_BOOT_SEGMENTS     256
+#define ARENA_SPARE_SEGMENTS    4
+// Page fault error code bits
+#define PAGE_FAULT_PRESENT      0x1
+#define PAGE_FAULT_WRITE        0x2
+// Write protect bit of CR0, makes the kernel honor read-only pages
+#define CR0_WRITE_PROTECT       0x10000
+// Page size extension bit of CR4, enables 4 MiB pages
+#define CR4_PAGE_SIZE_EXT       0x10
+// Page global enable bit of CR4, keeps global entries across CR3 reloads
+#define CR4_PAGE_GLOBAL         0x80
+// Physical address extension bit of CR4, switches to 64-bit entries
+#define CR4_PHYS_ADDR_EXT       0x20
+// CPUID leaf 1 EDX bits advertising page size extension, PAE, global page and PAT support
+#define CPUID_FEAT_EDX_PSE      (1 << 3)
+#define CPUID_FEAT_EDX_PAE      (1 << 6)
+#define CPUID_FEAT_EDX_PGE      (1 << 13)
+#define CPUID_FEAT_EDX_PAT      (1 << 16)
+// Page attribute table MSR. Entries are picked by the PAT, PCD and PWT bits
+// of an entry: WB, WC, UC-, UC, and the same again for the PAT bit so that
+// it (which is the page size bit in a PDE) never matters.
+#define MSR_PAT                 0x277
+#define PAT_VALUE               0x0007010600070106ULL
+#define LARGE_PAGE_FRAMES       (LARGE_PAGE_SIZE / PAGE_SIZE)
+// Frames kept at hand so that most page faults skip the frame allocator
+#define PAGING_FAULT_FRAMES     32
+// Virtual addresses set aside for task stacks and their guard pages
+#define KERNEL_STACK_REGION_SIZE    (64 * 1024 * 1024)
+#define KERNEL_STACK_SEGMENTS       128
+// The recursive mapping shows the current page tables and directory here,
+// it takes the last directory entry (the last four with PAE, one for each
+// page directory, which then show up next to each other)
+#ifdef PAGING_PAE
+#define PAGING_RECURSIVE_TABLES     0xFF800000
+#define PAGING_RECURSIVE_DIR        0xFFFFC000
+#else
+#define PAGING_RECURSIVE_TABLES     0xFFC00000
+#define PAGING_RECURSIVE_DIR        0xFFFFF000
+#endif
+#define PAGING_RECURSIVE_ENTRIES    ((ADDRESS_SPACE_SIZE - PAGING_RECURSIVE_TABLES) / LARGE_PAGE_SIZE)
+#define PAGING_RECURSIVE_FIRST      (PAGE_DIR_ENTRIES - PAGING_RECURSIVE_ENTRIES)
+// Page tables built into the image for mappings made before the frame
+// allocator is up (the kernel image, low memory and the boot information)
+#define PAGING_BOOT_TABLES          16
 
-/* one bit for every page */
-static size_t mem_map[MEM_BITMAP_SIZE] = { 0 };
-static size_t page_map[MEM_BITMAP_SIZE] = { 0 };
-static Bitset mapped_mem = Bitset(mem_map, MEM_BITMAP_SIZE);
-static Bitset mapped_pages = Bitset(page_map, MEM_BITMAP_SIZE);
+/* free kernel virtual address ranges (physical frames are tracked by the frame allocator) */
+static vmem_segment_t arena_boot_segments[ARENA_BOOT_SEGMENTS];
+static VmemArena kernel_arena;
 
 static uint32_t         page_dir_addr;
-static page_table_t*    page_dir_virt[PAGE_ENTRIES];
+static page_table_t*    page_dir_virt[PAGE_DIR_ENTRIES];
 
 /* both of these must be page aligned for anything to work right at all */
-static page_directory_entry_t page_dir_phys[PAGE_ENTRIES] __attribute__ ((section (".page_tables,\"aw\", @nobits#")));
-static page_table_t           page_tables[PAGE_ENTRIES]   __attribute__ ((section (".page_tables,\"aw\", @nobits#")));
+static page_directory_entry_t page_dir_phys[PAGE_DIR_ENTRIES] __attribute__ ((section (".page_tables,\"aw\", @nobits#")));
+static page_table_t           boot_tables[PAGING_BOOT_TABLES] __attribute__ ((section (".page_tables,\"aw\", @nobits#")));
+static uint32_t boot_tables_used = 0;
+#ifdef PAGING_PAE
+/* what CR3 points at with PAE, one entry for each page directory */
+static uint64_t page_dir_ptrs[PAGE_DIR_POINTERS] __attribute__ ((aligned (32)));
+#endif
+/* shared by every demand page that has been read but not written */
+static uint8_t zero_page[PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+static size_t fault_frames[PAGING_FAULT_FRAMES];
+static volatile size_t fault_frames_count = 0;
+
+/* task stacks are carved out of a region of their own */
+static vmem_segment_t stack_segments[KERNEL_STACK_SEGMENTS];
+static VmemArena stack_arena;
+static uintptr_t stack_region = 0;
+
+/* private windows of address spaces, frames they share are counted in the frame descriptors */
+static uintptr_t private_region = 0;
+static address_space_t *address_spaces = NULL;
+static kmem_cache_t *space_cache = NULL;
+/* entries of the temporary mappings and the slots in use */
+static page_table_entry_t *fixmap_entries = NULL;
+static volatile uint32_t fixmap_used = 0;
 
 // Function prototypes
 static void mem_page_fault(registers_t* regs);
+static bool paging_demand_fault(uintptr_t addr, uint32_t err_code);
+static void paging_refill_fault_frames();
+static size_t paging_fault_frame();
+static void paging_init_stacks();
+static void paging_init_features();
+static bool paging_map_large_page(virtual_address_t vaddr, phys_addr_t paddr, page_cache_t cache = PAGE_CACHE_WB,
+                                  mmu_gather_t *tlb = NULL);
+static bool paging_table_empty(uint32_t pd_idx);
 static void paging_init_dir();
 static void paging_map_early_mem();
 static void paging_map_hh_kernel();
-static uint32_t find_next_free_virt_addr(int seq);
-static uint32_t find_next_free_phys_page();
-static inline void map_kernel_page_table(uint32_t pd_idx, page_table_t *table);
+static void paging_init_arena();
+static void paging_init_fixmap();
+static void paging_refill_arena();
+static void paging_map_page(virtual_address_t vaddr, phys_addr_t paddr, page_cache_t cache = PAGE_CACHE_WB,
+                            mmu_gather_t *tlb = NULL);
+static bool paging_map_kernel_large(virtual_address_t vaddr, phys_addr_t paddr, page_cache_t cache,
+                                    mmu_gather_t *tlb);
+static size_t paging_map_run(virtual_address_t vaddr, phys_addr_t paddr, size_t count, bool write,
+                             page_cache_t cache, mmu_gather_t *tlb);
+static void paging_reserve_run(uintptr_t start, size_t size);
+static void paging_demand_run(uintptr_t start, uintptr_t end);
+static void* paging_new_pages(uint32_t page_count);
+static inline uint32_t paging_cache_pwt(page_cache_t cache);
+static inline uint32_t paging_cache_pcd(page_cache_t cache);
+static void paging_cache_changed(uintptr_t vaddr, mmu_gather_t *tlb);
+static void mmu_gather_page(mmu_gather_t *tlb, uintptr_t vaddr);
+static void mmu_gather_frames(mmu_gather_t *tlb, size_t first, size_t count);
+static size_t paging_unmap_range(mmu_gather_t *tlb, uintptr_t start, uintptr_t end);
+static inline bool paging_is_private(uintptr_t addr);
+static inline bool paging_is_global(uintptr_t addr);
+static inline size_t paging_irq_save();
+static inline void paging_irq_restore(size_t flags);
+static void paging_sync_pde(uint32_t pd_idx);
+static bool paging_cow_fault(page_table_entry_t *entry, void *page);
+static void address_space_destroy(address_space_t *space);
+static bool address_space_set_dir(address_space_t *space, page_directory_entry_t *dir);
+static page_table_t *address_space_table(address_space_t *space, uintptr_t vaddr);
+static page_table_t *paging_table(uint32_t pd_idx);
+static void paging_release_table(uint32_t pd_idx, uint32_t table_frame);
+static void paging_clear_pde(uint32_t pd_idx);
+static bool paging_split_large_page(uint32_t pd_idx);
+static bool paging_move_large_page(uint32_t from, uint32_t to);
+static inline page_table_entry_t *paging_get_entry(uintptr_t addr);
+static inline page_table_entry_t *paging_find_entry(uintptr_t addr);
+static inline void map_kernel_page_table(uint32_t pd_idx, page_table_t *table, phys_addr_t table_phys);
 static inline void set_page_dir(uint32_t page_directory);
 static inline void paging_enable();
 static inline void paging_disable();
+#ifdef PAGING_PAE
+extern "C" void paging_enable_pae(uint32_t page_dir_ptrs);
+#endif
 
 void paging_init(uint32_t page_count) {
     machine_page_count = page_count;
     // we can set breakpoints or make a futile attempt to recover.
     register_interrupt_handler(14, mem_page_fault);
+    // use large pages and global kernel pages where possible
+    paging_init_features();
+    // set up the kernel virtual address arena
+    paging_init_arena();
     // init our structures
     paging_init_dir();
-    // identity map the first 1 MiB of RAM
+    mem_stats_add(MEM_OWNER_PAGE_TABLES, sizeof(page_dir_phys) / PAGE_SIZE);
+    // the fixmap table has to exist before anything may fault
+    paging_init_fixmap();
+    // identity map the first 1 MiB of RAM and the early kernel
     paging_map_early_mem();
     // map in our higher-half kernel
     paging_map_hh_kernel();
     // use our new set of page tables
+#ifdef PAGING_PAE
+    // PAE can only be turned on with paging off, which is done from the
+    // identity mapped early kernel (see paging_asm.s)
+    tss_set_page_dir(page_dir_addr);
+    paging_enable_pae(page_dir_addr);
+#else
     set_page_dir(page_dir_addr & PAGE_ALIGN);
+#endif
     // flush the tlb and we're off to the races!
     paging_enable();
+    // new page tables can be reached through the recursive mapping now
+    paging_active = true;
 }
 
 static void mem_page_fault(registers_t* regs) {
-   PANIC(regs);
+    // The faulting address is stored in the CR2 register.
+    uintptr_t addr;
+    asm volatile("mov %%cr2, %0" : "=r"(addr));
+    if (!paging_demand_fault(addr, regs->err_code)) {
+        PANIC(regs);
+    }
+}
+
+static bool paging_demand_fault(uintptr_t addr, uint32_t err_code) {
+    // Page faults are delivered to a task of their own and may interrupt
+    // code holding any lock (including the paging lock), so nothing here
+    // may block. Only the faulting entry is touched and frames come from
+    // the fault reserve, or straight from the frame allocator (which only
+    // ever runs with interrupts off) once that is used up.
+    // The recursive mapping shows the tables of whichever address space
+    // is current, private or shared, without taking any locks
+    page_table_entry_t *entry = NULL;
+    page_directory_entry_t pde = ((page_directory_entry_t *)PAGING_RECURSIVE_DIR)[VADDR(addr).page_dir_index];
+    if (pde.present && !pde.page_size) {
+        entry = (page_table_entry_t *)PAGING_RECURSIVE_TABLES + (addr >> 12);
+    }
+    uint32_t zero_frame = KADDR_TO_PHYS((uint32_t)zero_page) >> 12;
+    bool write = err_code & PAGE_FAULT_WRITE;
+    void *page = (void *)(addr & PAGE_ALIGN);
+    if (entry != NULL && entry->present && entry->cow && write) {
+        return paging_cow_fault(entry, page);
+    }
+    if (entry == NULL || !entry->demand) {
+        if (addr >= stack_region && addr < stack_region + KERNEL_STACK_REGION_SIZE) {
+            // Neither committed nor committable, so this is a guard page
+            PANIC("Kernel stack overflow (hit a stack guard page).\n");
+        }
+        return false;
+    }
+    if (entry->present && (!write || entry->read_write)) {
+        // A stale TLB entry, the page is already usable
+        invalidate_page(page);
+        return true;
+    }
+    if (!write) {
+        // Reads are satisfied by the zero page until the first write
+        entry->frame = zero_frame;
+        entry->read_write = 0;
+        entry->global = paging_is_global(addr);
+        entry->present = 1;
+        invalidate_page(page);
+        return true;
+    }
+    // A write to a missing page or to the zero page gets a zeroed frame
+    // of its own, preferably one the idle loop already cleared
+    size_t frame = get_zeroed_frame();
+    if (frame == SIZE_MAX) {
+        PANIC("Out of frames to back a demand page.\n");
+    }
+    if (addr >= stack_region && addr < stack_region + KERNEL_STACK_REGION_SIZE) {
+        mem_stats_add(MEM_OWNER_STACKS, 1);
+    }
+    *entry = {
+        .present = 1,
+        .read_write = 1,
+        .usermode = 0,
+        .write_through = 0,
+        .cache_disable = 0,
+        .accessed = 0,
+        .dirty = 0,
+        .page_att_table = 0,
+        .global = paging_is_global(addr),
+        .demand = 0,
+        .cow = 0,
+        .unused = 0,
+        .frame = frame
+    };
+    invalidate_page(page);
+    return true;
+}
+
+static bool paging_cow_fault(page_table_entry_t *entry, void *page) {
+    if (!frame_unshare(entry->frame)) {
+        // Every other address space let go of the frame already
+        entry->read_write = 1;
+        entry->cow = 0;
+        invalidate_page(page);
+        return true;
+    }
+    // The new frame is filled through a temporary mapping before the
+    // entry is switched over to it
+    size_t frame = paging_fault_frame();
+    if (frame == SIZE_MAX) {
+        PANIC("Out of frames to copy a shared page.\n");
+    }
+    void *copy = kmap_temp(FRAME_TO_PHYS(frame));
+    if (copy == NULL) {
+        PANIC("Out of temporary mappings to copy a shared page.\n");
+    }
+    memcpy(copy, page, PAGE_SIZE);
+    kunmap_temp(copy);
+    entry->frame = frame;
+    entry->read_write = 1;
+    entry->cow = 0;
+    invalidate_page(page);
+    return true;
+}
+
+static void paging_refill_fault_frames() {
+    // Called with the paging lock held from ordinary task context. A
+    // fault may take frames from any other task in between, so the
+    // reserve only changes with interrupts off.
+    while (true) {
+        size_t flags = paging_irq_save();
+        bool full = fault_frames_count >= PAGING_FAULT_FRAMES;
+        size_t frame = full ? SIZE_MAX : frames_alloc();
+        if (frame != SIZE_MAX) {
+            fault_frames[fault_frames_count] = frame;
+            fault_frames_count = fault_frames_count + 1;
+        }
+        paging_irq_restore(flags);
+        if (frame == SIZE_MAX) break;
+    }
+    // The zero pool is topped up alongside, its lock never takes ours
+    zero_pool_refill();
+}
+
+// Called from the page fault task, the reserve only saves a trip to the
+// frame allocator
+static size_t paging_fault_frame() {
+    if (fault_frames_count > 0) {
+        fault_frames_count = fault_frames_count - 1;
+        return fault_frames[fault_frames_count];
+    }
+    return frames_alloc();
+}
+
+// Called with the paging lock held
+static page_table_t *paging_table(uint32_t pd_idx) {
+    if (page_dir_virt[pd_idx] != NULL) {
+        return page_dir_virt[pd_idx];
+    }
+    if (page_dir_phys[pd_idx].page_size) {
+        PANIC("Attempted to add a page table beneath a large page.\n");
+    }
+    page_table_t *table;
+    phys_addr_t table_phys;
+    size_t frame = paging_active ? get_zeroed_frame() : SIZE_MAX;
+    bool zeroed = frame != SIZE_MAX;
+    if (zeroed) {
+        // reached through the recursive mapping like any other table
+        table = (page_table_t *)(PAGING_RECURSIVE_TABLES + pd_idx * PAGE_SIZE);
+        table_phys = FRAME_TO_PHYS(frame);
+        frame_set_flags(frame, FRAME_PAGE_TABLE);
+        frame_desc(frame)->owner = MEM_OWNER_PAGE_TABLES;
+    } else {
+        // the frame allocator is not up yet, so use one from the image
+        if (boot_tables_used == (1U << PAGING_BOOT_TABLES) - 1) {
+            PANIC("Out of boot page tables.\n");
+        }
+        size_t idx = __builtin_ctz(~boot_tables_used);
+        boot_tables_used |= 1U << idx;
+        table = &boot_tables[idx];
+        table_phys = KADDR_TO_PHYS((uint32_t)table);
+    }
+    // The old contents are live until cleared, keep the fault task out
+    size_t flags = paging_irq_save();
+    map_kernel_page_table(pd_idx, table, table_phys);
+    invalidate_page(table);
+    if (!zeroed) {
+        memset(table, 0, PAGE_SIZE);
+    }
+    paging_irq_restore(flags);
+    mem_stats_add(MEM_OWNER_PAGE_TABLES, 1);
+    return table;
+}
+
+// Called with the paging lock held once the entry no longer points at the table
+static void paging_release_table(uint32_t pd_idx, uint32_t table_frame) {
+    page_table_t *table = page_dir_virt[pd_idx];
+    page_dir_virt[pd_idx] = NULL;
+    if (table == NULL) {
+        return;
+    }
+    // Walks of the old entry may be cached for any address it covered
+    invalidate_page((void *)(pd_idx * LARGE_PAGE_SIZE));
+    if (table >= &boot_tables[0] && table < &boot_tables[PAGING_BOOT_TABLES]) {
+        boot_tables_used &= ~(1U << (table - &boot_tables[0]));
+    } else {
+        invalidate_page(table);
+        frames_free(table_frame);
+    }
+    mem_stats_sub(MEM_OWNER_PAGE_TABLES, 1);
+}
+
+// Called with the paging lock held, the caller flushes the addresses
+static void paging_clear_pde(uint32_t pd_idx) {
+    page_dir_phys[pd_idx] = { /* Zero */ };
+    paging_sync_pde(pd_idx);
+}
+
+// Called with the paging lock held. The page table maps the same frames as
+// the large page did, so that part of them can be unmapped.
+static bool paging_split_large_page(uint32_t pd_idx) {
+    size_t frame = frames_alloc();
+    if (frame == SIZE_MAX) {
+        return false;
+    }
+    page_table_t *fill = (page_table_t *)kmap_temp(FRAME_TO_PHYS(frame));
+    if (fill == NULL) {
+        frames_free(frame);
+        return false;
+    }
+    page_directory_entry_t large = page_dir_phys[pd_idx];
+    for (size_t i = 0; i < PAGE_ENTRIES; i++) {
+        fill->pages[i] = {
+            .present = 1,
+            .read_write = large.read_write,
+            .usermode = 0,
+            .write_through = large.write_through,
+            .cache_disable = large.cache_disable,
+            .accessed = 0,
+            .dirty = 0,
+            .page_att_table = 0,
+            .global = large.global,
+            .demand = 0,
+            .cow = 0,
+            .unused = 0,
+            .frame = large.table_addr + i
+        };
+    }
+    kunmap_temp(fill);
+    frame_set_flags(frame, FRAME_PAGE_TABLE);
+    frame_desc(frame)->owner = MEM_OWNER_PAGE_TABLES;
+    page_table_t *table = (page_table_t *)(PAGING_RECURSIVE_TABLES + pd_idx * PAGE_SIZE);
+    size_t flags = paging_irq_save();
+    map_kernel_page_table(pd_idx, table, FRAME_TO_PHYS(frame));
+    invalidate_page(table);
+    // a single invlpg drops the whole large page from the tlb
+    invalidate_page((void *)(pd_idx * LARGE_PAGE_SIZE));
+    paging_irq_restore(flags);
+    mem_stats_add(MEM_OWNER_PAGE_TABLES, 1);
+    return true;
+}
+
+// Called with the paging lock held, the caller flushes the old addresses
+static bool paging_move_large_page(uint32_t from, uint32_t to) {
+    if (!paging_table_empty(to)) {
+        return false;
+    }
+    uint32_t table_frame = page_dir_phys[to].table_addr;
+    page_directory_entry_t entry = page_dir_phys[from];
+    entry.global = paging_is_global(to * LARGE_PAGE_SIZE);
+    page_dir_phys[to] = entry;
+    paging_sync_pde(to);
+    paging_release_table(to, table_frame);
+    paging_clear_pde(from);
+    return true;
+}
+
+static inline page_table_entry_t *paging_get_entry(uintptr_t addr) {
+    virtual_address_t vaddr = VADDR(addr);
+    return &(paging_table(vaddr.page_dir_index)->pages[vaddr.page_table_index]);
 }
 
-static inline void map_kernel_page_table(uint32_t pd_idx, page_table_t *table) {
+static inline page_table_entry_t *paging_find_entry(uintptr_t addr) {
+    virtual_address_t vaddr = VADDR(addr);
+    page_table_t *table = page_dir_virt[vaddr.page_dir_index];
+    return table ? &table->pages[vaddr.page_table_index] : NULL;
+}
+
+static inline void map_kernel_page_table(uint32_t pd_idx, page_table_t *table, phys_addr_t table_phys) {
     page_dir_virt[pd_idx] = table;
     page_dir_phys[pd_idx] = {
         .present = 1,
@@ -81,35 +483,528 @@ static inline void map_kernel_page_table(uint32_t pd_idx, page_table_t *table) {
         .accessed = 0,
         .ignored_a = 0,
         .page_size = 0,
+        .global = 0,
         .ignored_b = 0,
-        // compute the physical address of this page table
-        // the virtual address is obtained with the & operator and
-        // the offset is applied from the load address of the kernel
         // we must shift it over 12 bits because we only care about
-        // the highest 20 bits for the page table
-        .table_addr = KADDR_TO_PHYS((uint32_t)table) >> 12
+        // the frame of the page table
+        .table_addr = table_phys >> 12
     };
+    paging_sync_pde(pd_idx);
 }
 
 static void paging_init_dir() {
-    // For every page in kernel memory
-    for (int i = 0; i < PAGE_ENTRIES - 1; i++) {
-        map_kernel_page_table(i, &page_tables[i]);
-        // clear out the page tables
-        for (int j = 0; j < PAGE_ENTRIES; j++) {
-            page_tables[i].pages[j] = (page_table_entry_t){ /* ZERO */ };
-        }
+    // Page tables are only added once something is mapped beneath them,
+    // so the directory starts out empty
+    memset(page_dir_phys, 0, sizeof(page_dir_phys));
+    // recursively map the last page table(s) to the page directory
+    for (uint32_t i = 0; i < PAGING_RECURSIVE_ENTRIES; i++) {
+        page_directory_entry_t *dir = &page_dir_phys[i * PAGE_ENTRIES];
+        map_kernel_page_table(PAGING_RECURSIVE_FIRST + i, (page_table_t*)dir, KADDR_TO_PHYS((uint32_t)dir));
     }
-    // recursively map the last page table to the page directory
-    map_kernel_page_table(PAGE_ENTRIES - 1, (page_table_t*)&page_dir_phys[0]);
-    for (uint32_t i = PAGE_ENTRIES * (PAGE_ENTRIES - 1); i < PAGE_ENTRIES * PAGE_ENTRIES; i++) {
-        mapped_pages.Set(i);
+#ifdef PAGING_PAE
+    // the pointer table only holds the present bit and the directories
+    for (uint32_t i = 0; i < PAGE_DIR_POINTERS; i++) {
+        page_dir_ptrs[i] = KADDR_TO_PHYS((uint32_t)&page_dir_phys[i * PAGE_ENTRIES]) | PAGE_ENTRY_PRESENT;
     }
+    page_dir_addr = KADDR_TO_PHYS((uint32_t)&page_dir_ptrs[0]);
+#else
     // store the physical address of the page directory for quick access
     page_dir_addr = KADDR_TO_PHYS((uint32_t)&page_dir_phys[0]);
+#endif
+}
+
+static void paging_init_features() {
+    unsigned int eax, ebx, ecx, edx;
+    bool cpuid = __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+#ifdef PAGING_PAE
+    if (!cpuid || !(edx & CPUID_FEAT_EDX_PAE)) {
+        PANIC("This kernel was built for PAE paging, which the processor does not support.\n");
+    }
+#endif
+    if (!cpuid) {
+        return;
+    }
+#ifdef PAGING_PAE
+    // 2 MiB pages come with PAE, PSE only adds 4 MiB pages to legacy paging
+    paging_pse = true;
+#else
+    paging_pse = edx & CPUID_FEAT_EDX_PSE;
+#endif
+    paging_pge = edx & CPUID_FEAT_EDX_PGE;
+    paging_pat = edx & CPUID_FEAT_EDX_PAT;
+    if (paging_pat) {
+        // Nothing is mapped with PWT set yet, so no cache lines can have
+        // the old write-through type of the entry that becomes WC
+        uint64_t pat = PAT_VALUE;
+        asm volatile("wrmsr" :: "c"(MSR_PAT), "a"((uint32_t)pat), "d"((uint32_t)(pat >> 32)));
+    }
+    size_t cr4;
+    asm volatile("mov %%cr4, %0" : "=r"(cr4));
+    if (paging_pse) cr4 |= CR4_PAGE_SIZE_EXT;
+    // Higher half mappings are the same in every address space, so they
+    // are marked global and kept in the TLB when CR3 is reloaded
+    if (paging_pge) cr4 |= CR4_PAGE_GLOBAL;
+    asm volatile("mov %0, %%cr4" :: "r"(cr4));
+}
+
+void paging_flush_tlb() {
+    size_t cr4;
+    asm volatile("mov %%cr4, %0" : "=r"(cr4));
+    if (cr4 & CR4_PAGE_GLOBAL) {
+        // toggling PGE flushes everything, global entries included
+        asm volatile("mov %0, %%cr4" :: "r"(cr4 & ~CR4_PAGE_GLOBAL) : "memory");
+        asm volatile("mov %0, %%cr4" :: "r"(cr4) : "memory");
+    } else {
+        size_t cr3;
+        asm volatile("mov %%cr3, %0" : "=r"(cr3));
+        asm volatile("mov %0, %%cr3" :: "r"(cr3) : "memory");
+    }
+}
+
+static bool paging_table_empty(uint32_t pd_idx) {
+    page_table_t *table = page_dir_virt[pd_idx];
+    for (size_t i = 0; table != NULL && i < PAGE_ENTRIES; i++) {
+        page_table_entry_t entry = table->pages[i];
+        if (entry.present || entry.demand) return false;
+    }
+    return true;
+}
+
+static inline uint32_t paging_cache_pwt(page_cache_t cache) {
+    return cache == PAGE_CACHE_UC || (cache == PAGE_CACHE_WC && paging_pat);
+}
+
+static inline uint32_t paging_cache_pcd(page_cache_t cache) {
+    // Without PAT, write-combining falls back to uncached-minus, which
+    // still lets an MTRR make the range write-combining
+    return cache == PAGE_CACHE_UC || (cache == PAGE_CACHE_WC && !paging_pat);
+}
+
+static void paging_cache_changed(uintptr_t vaddr, mmu_gather_t *tlb) {
+    if (tlb != NULL) {
+        mmu_gather_page(tlb, vaddr);
+        tlb->write_back = true;
+        return;
+    }
+    // Lines cached under the old memory type must not linger
+    invalidate_page((void *)vaddr);
+    asm volatile("wbinvd" ::: "memory");
+}
+
+void mmu_gather_init(mmu_gather_t *tlb) {
+    tlb->page_count = 0;
+    tlb->flush_all = false;
+    tlb->write_back = false;
+    tlb->frame_count = 0;
+}
+
+static void mmu_gather_page(mmu_gather_t *tlb, uintptr_t vaddr) {
+    // Past a handful of pages a full flush is cheaper than invlpg on each
+    if (tlb->page_count < MMU_GATHER_PAGES) {
+        tlb->pages[tlb->page_count++] = vaddr;
+    } else {
+        tlb->flush_all = true;
+    }
+}
+
+static void mmu_gather_frames(mmu_gather_t *tlb, size_t first, size_t count) {
+    if (tlb->frame_count == MMU_GATHER_FRAMES) {
+        mmu_gather_finish(tlb);
+    }
+    tlb->frames[tlb->frame_count].first = first;
+    tlb->frames[tlb->frame_count].count = count;
+    tlb->frame_count++;
+}
+
+void mmu_gather_finish(mmu_gather_t *tlb) {
+    if (tlb->flush_all) {
+        // kernel pages are global, so reloading CR3 would not do
+        paging_flush_tlb();
+    } else {
+        for (size_t i = 0; i < tlb->page_count; i++) {
+            invalidate_page((void *)tlb->pages[i]);
+        }
+    }
+    if (tlb->write_back) {
+        asm volatile("wbinvd" ::: "memory");
+    }
+    // Nothing can reach the frames through the TLB anymore
+    for (size_t i = 0; i < tlb->frame_count; i++) {
+        if (tlb->frames[i].count == 1) {
+            frames_free(tlb->frames[i].first);
+        } else {
+            frames_free_contiguous(tlb->frames[i].first, tlb->frames[i].count);
+        }
+    }
+    mmu_gather_init(tlb);
+}
+
+static size_t paging_unmap_range(mmu_gather_t *tlb, uintptr_t start, uintptr_t end) {
+    uint32_t zero_frame = KADDR_TO_PHYS((uint32_t)zero_page) >> 12;
+    size_t frames = 0;
+    for (uintptr_t page = start & PAGE_ALIGN; page < end; page += PAGE_SIZE) {
+        page_directory_entry_t *pde = &page_dir_phys[VADDR(page).page_dir_index];
+        if (pde->page_size) {
+            // a whole large page goes back in one piece, its frames are
+            // never split up
+            if ((page & ~LARGE_PAGE_ALIGN) != 0 || end - page < LARGE_PAGE_SIZE) {
+                PANIC("Attempted to unmap part of a large page.\n");
+            }
+            mmu_gather_frames(tlb, pde->table_addr, LARGE_PAGE_FRAMES);
+            frames += LARGE_PAGE_FRAMES;
+            paging_clear_pde(VADDR(page).page_dir_index);
+            mmu_gather_page(tlb, page);
+            page = (page & LARGE_PAGE_ALIGN) + LARGE_PAGE_SIZE - PAGE_SIZE;
+            continue;
+        }
+        page_table_entry_t *pte = paging_find_entry(page);
+        if (pte == NULL) {
+            // nothing was ever mapped beneath this entry
+            page = (page & LARGE_PAGE_ALIGN) + LARGE_PAGE_SIZE - PAGE_SIZE;
+            continue;
+        }
+        // demand pages may never have been backed, or only by the zero page
+        if (pte->present && pte->frame != zero_frame) {
+            mmu_gather_frames(tlb, pte->frame, 1);
+            frames++;
+        }
+        // only entries that may be cached need to be invalidated
+        if (pte->present) {
+            mmu_gather_page(tlb, page);
+        }
+        // zero it out to unmap it
+        *pte = { /* Zero */ };
+    }
+    return frames;
+}
+
+void mmu_gather_unmap(mmu_gather_t *tlb, void *addr, uint32_t size) {
+    mutex_lock(&mutex_paging);
+    paging_unmap_range(tlb, (uintptr_t)addr, (uintptr_t)addr + size);
+    mutex_unlock(&mutex_paging);
+}
+
+static bool paging_map_large_page(virtual_address_t vaddr, phys_addr_t paddr, page_cache_t cache, mmu_gather_t *tlb) {
+    uint32_t pde = vaddr.page_dir_index;
+    if (!paging_pse || (vaddr.val | paddr) & ~LARGE_PAGE_ALIGN) {
+        return false;
+    }
+    if (page_dir_phys[pde].page_size) {
+        // already a large page, fine as long as it is the same one
+        if (page_dir_phys[pde].table_addr != paddr >> 12) {
+            return false;
+        }
+        if (page_dir_phys[pde].write_through != paging_cache_pwt(cache) ||
+            page_dir_phys[pde].cache_disable != paging_cache_pcd(cache)) {
+            page_dir_phys[pde].write_through = paging_cache_pwt(cache);
+            page_dir_phys[pde].cache_disable = paging_cache_pcd(cache);
+            paging_sync_pde(pde);
+            paging_cache_changed(vaddr.val, tlb);
+        }
+        return true;
+    }
+    // the page table may not be in use, it is given back afterwards
+    if (!paging_table_empty(pde)) {
+        return false;
+    }
+    uint32_t table_frame = page_dir_phys[pde].table_addr;
+    debugf("map frame 0x%05x to 0x%08x, pde = 0x%08x (large)\n", (size_t)(paddr >> 12), vaddr.val, pde);
+    page_dir_phys[pde] = {
+        .present = 1,
+        .read_write = 1,
+        .usermode = 0,
+        .write_through = paging_cache_pwt(cache),
+        .cache_disable = paging_cache_pcd(cache),
+        .accessed = 0,
+        .ignored_a = 0,
+        .page_size = 1,         // This entry maps a large page
+        .global = paging_is_global(vaddr.val),
+        .ignored_b = 0,
+        .table_addr = paddr >> 12
+    };
+    paging_sync_pde(pde);
+    paging_release_table(pde, table_frame);
+    return true;
+}
+
+bool map_kernel_large_page(virtual_address_t vaddr, phys_addr_t paddr, page_cache_t cache, mmu_gather_t *tlb) {
+    mutex_lock(&mutex_paging);
+    bool mapped = paging_map_kernel_large(vaddr, paddr, cache, tlb);
+    mutex_unlock(&mutex_paging);
+    return mapped;
+}
+
+// Called with the paging lock held
+static bool paging_map_kernel_large(virtual_address_t vaddr, phys_addr_t paddr, page_cache_t cache, mmu_gather_t *tlb) {
+    bool mapped = false;
+    bool in_arena = vaddr.val + LARGE_PAGE_SIZE > PAGE_ALIGN_UP(KERNEL_END) && vaddr.val < KERNEL_ARENA_END;
+    if (paging_pse && !((vaddr.val | paddr) & ~LARGE_PAGE_ALIGN)) {
+        if (in_arena) {
+            paging_refill_arena();
+        }
+        // Only take addresses out of the arena if all of them are free
+        if (!in_arena || kernel_arena.Reserve(vaddr.val, LARGE_PAGE_SIZE)) {
+            mapped = paging_map_large_page(vaddr, paddr, cache, tlb);
+            if (!mapped && in_arena) {
+                kernel_arena.Free(vaddr.val, LARGE_PAGE_SIZE);
+            }
+        } else {
+            // Already reserved, so it may be mapped the same way already
+            mapped = page_dir_phys[vaddr.page_dir_index].page_size &&
+                paging_map_large_page(vaddr, paddr, cache, tlb);
+        }
+    }
+    return mapped;
+}
+
+size_t map_kernel_range(uintptr_t vaddr, phys_addr_t paddr, size_t size, uint32_t flags,
+                        page_cache_t cache, mmu_gather_t *tlb) {
+    if ((vaddr ^ paddr) & NOT_PAGE_ALIGN) {
+        PANIC("Attempted to map a range with mismatched page offsets.\n");
+    }
+    // counted in pages so that a range ending at 4 GiB does not wrap
+    size_t pages = ((vaddr & NOT_PAGE_ALIGN) + size + PAGE_SIZE - 1) / PAGE_SIZE;
+    uintptr_t page = vaddr & PAGE_ALIGN;
+    paddr -= paddr & NOT_PAGE_ALIGN;
+    size_t written = 0;
+    debugf("map frame 0x%05x to 0x%08x, %u pages\n", (size_t)(paddr >> 12), page, pages);
+    mutex_lock(&mutex_paging);
+    while (pages > 0) {
+        virtual_address_t a = VADDR(page);
+        // Large pages are always writable, so read-only ranges stick to
+        // 4 KiB pages rather than silently keep a writable one
+        if ((flags & PAGE_MAP_LARGE) && (flags & PAGE_MAP_WRITE) && pages >= LARGE_PAGE_FRAMES) {
+            page_directory_entry_t before = page_dir_phys[a.page_dir_index];
+            if (paging_map_kernel_large(a, paddr, cache, tlb)) {
+                written += memcmp(&before, &page_dir_phys[a.page_dir_index], sizeof(before)) != 0;
+                page += LARGE_PAGE_SIZE;
+                paddr += LARGE_PAGE_SIZE;
+                pages -= LARGE_PAGE_FRAMES;
+                continue;
+            }
+        }
+        // everything up to the end of this page table in one go
+        size_t run = PAGE_ENTRIES - a.page_table_index;
+        if (run > pages) {
+            run = pages;
+        }
+        paging_reserve_run(page, run * PAGE_SIZE);
+        written += paging_map_run(a, paddr, run, flags & PAGE_MAP_WRITE, cache, tlb);
+        page += run * PAGE_SIZE;
+        paddr += run * PAGE_SIZE;
+        pages -= run;
+    }
+    mutex_unlock(&mutex_paging);
+    return written;
+}
+
+// Called with the paging lock held
+static void paging_reserve_run(uintptr_t start, size_t size) {
+    // Fixed mappings that land inside the arena take their addresses out
+    // of it. Parts of the run may be reserved by an earlier mapping of the
+    // same pages already, so fall back to going page by page.
+    if (start + size <= PAGE_ALIGN_UP(KERNEL_END) || start >= KERNEL_ARENA_END) {
+        return;
+    }
+    paging_refill_arena();
+    if (kernel_arena.Reserve(start, size)) {
+        return;
+    }
+    for (uintptr_t page = start; page < start + size; page += PAGE_SIZE) {
+        if (page >= PAGE_ALIGN_UP(KERNEL_END) && page < KERNEL_ARENA_END) {
+            paging_refill_arena();
+            kernel_arena.Reserve(page, PAGE_SIZE);
+        }
+    }
+}
+
+// Called with the paging lock held, count may not cross a page table
+static size_t paging_map_run(virtual_address_t vaddr, phys_addr_t paddr, size_t count, bool write,
+                             page_cache_t cache, mmu_gather_t *tlb) {
+    uint32_t pde = vaddr.page_dir_index;
+    if (page_dir_phys[pde].page_size) {
+        // covered by a large page, which has to map it the same way
+        if (page_dir_phys[pde].table_addr + (vaddr.val & ~LARGE_PAGE_ALIGN) / PAGE_SIZE == paddr >> 12 &&
+            page_dir_phys[pde].read_write == write) {
+            return 0;
+        }
+        PANIC("Attempted to map a page inside a differently mapped large page.\n");
+    }
+    page_table_entry_t *entry = &paging_table(pde)->pages[vaddr.page_table_index];
+    size_t frame = paddr >> 12;
+    size_t written = 0;
+    for (size_t i = 0; i < count; i++, entry++, frame++) {
+        uintptr_t page = vaddr.val + i * PAGE_SIZE;
+        if (entry->present) {
+            if (entry->frame != frame) {
+                PANIC("Attempted to map already mapped page.\n");
+            }
+            if (entry->write_through != paging_cache_pwt(cache) ||
+                entry->cache_disable != paging_cache_pcd(cache)) {
+                entry->write_through = paging_cache_pwt(cache);
+                entry->cache_disable = paging_cache_pcd(cache);
+                entry->read_write = write;
+                paging_cache_changed(page, tlb);
+                written++;
+            } else if (entry->read_write != write) {
+                entry->read_write = write;
+                if (tlb != NULL) {
+                    mmu_gather_page(tlb, page);
+                } else {
+                    invalidate_page((void *)page);
+                }
+                written++;
+            }
+            continue;
+        }
+        *entry = {
+            .present = 1,
+            .read_write = write,
+            .usermode = 0,
+            .write_through = paging_cache_pwt(cache),
+            .cache_disable = paging_cache_pcd(cache),
+            .accessed = 0,
+            .dirty = 0,
+            .page_att_table = 0,
+            .global = paging_is_global(page),
+            .demand = 0,
+            .cow = 0,
+            .unused = 0,
+            .frame = frame
+        };
+        written++;
+    }
+    return written;
+}
+
+size_t unmap_kernel_range(uintptr_t vaddr, size_t size, mmu_gather_t *tlb) {
+    mmu_gather_t local;
+    if (tlb == NULL) {
+        mmu_gather_init(&local);
+        tlb = &local;
+    }
+    size_t pages = ((vaddr & NOT_PAGE_ALIGN) + size + PAGE_SIZE - 1) / PAGE_SIZE;
+    uintptr_t page = vaddr & PAGE_ALIGN;
+    size_t cleared = 0;
+    mutex_lock(&mutex_paging);
+    while (pages > 0) {
+        virtual_address_t a = VADDR(page);
+        size_t step = 1;
+        bool mapped = false;
+        if (page_dir_phys[a.page_dir_index].page_size) {
+            if (a.page_table_index != 0 || pages < LARGE_PAGE_FRAMES) {
+                PANIC("Attempted to unmap part of a large page.\n");
+            }
+            paging_clear_pde(a.page_dir_index);
+            mmu_gather_page(tlb, page);
+            step = LARGE_PAGE_FRAMES;
+            mapped = true;
+        } else {
+            page_table_entry_t *entry = paging_find_entry(page);
+            if (entry != NULL && entry->present) {
+                *entry = { /* Zero */ };
+                mmu_gather_page(tlb, page);
+                mapped = true;
+            }
+        }
+        // hand the addresses back if they were taken from the arena
+        if (mapped) {
+            cleared++;
+            if (page >= PAGE_ALIGN_UP(KERNEL_END) && page < KERNEL_ARENA_END) {
+                paging_refill_arena();
+                kernel_arena.Free(page, step * PAGE_SIZE);
+            }
+        }
+        page += step * PAGE_SIZE;
+        pages -= step;
+    }
+    mutex_unlock(&mutex_paging);
+    if (tlb == &local) {
+        mmu_gather_finish(&local);
+    }
+    return cleared;
+}
+
+static void paging_init_arena() {
+    uintptr_t start = PAGE_ALIGN_UP(KERNEL_END);
+    kernel_arena = VmemArena(PAGE_SIZE);
+    kernel_arena.AddSegments(arena_boot_segments, sizeof(arena_boot_segments));
+    kernel_arena.Add(start, KERNEL_ARENA_END - start);
+}
+
+static void paging_init_fixmap() {
+    // Kept in a boot table, so the slots never need a page table allocated
+    fixmap_entries = &paging_table(VADDR(FIXMAP_BASE).page_dir_index)->pages[VADDR(FIXMAP_BASE).page_table_index];
+}
+
+void *kmap_temp(phys_addr_t paddr) {
+    // Lock free so that the page fault task can use it as well
+    uint32_t used = fixmap_used;
+    size_t slot;
+    do {
+        if (used == FIXMAP_ALL) {
+            return NULL;
+        }
+        slot = __builtin_ctz(~used);
+    } while (!__atomic_compare_exchange_n(&fixmap_used, &used, used | (1U << slot), true,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+    // The slot was flushed when it was last unmapped
+    fixmap_entries[slot] = {
+        .present = 1,
+        .read_write = 1,
+        .usermode = 0,
+        .write_through = 0,
+        .cache_disable = 0,
+        .accessed = 0,
+        .dirty = 0,
+        .page_att_table = 0,
+        .global = 1,
+        .demand = 0,
+        .cow = 0,
+        .unused = 0,
+        .frame = paddr >> 12
+    };
+    return (void *)(FIXMAP_BASE + slot * PAGE_SIZE + (uintptr_t)(paddr & NOT_PAGE_ALIGN));
+}
+
+void kunmap_temp(void *addr) {
+    uintptr_t page = (uintptr_t)addr & PAGE_ALIGN;
+    size_t slot = (page - FIXMAP_BASE) / PAGE_SIZE;
+    if (page < FIXMAP_BASE || slot >= FIXMAP_SLOTS) {
+        PANIC("Attempted to remove a mapping not made by kmap_temp().\n");
+    }
+    fixmap_entries[slot] = { /* Zero */ };
+    invalidate_page((void *)page);
+    __atomic_and_fetch(&fixmap_used, ~(1U << slot), __ATOMIC_RELEASE);
+}
+
+static void paging_refill_arena() {
+    // Keep enough descriptors around for any single arena operation.
+    // The page holding the new descriptors comes from the arena itself.
+    if (kernel_arena.SpareSegments() >= ARENA_SPARE_SEGMENTS) return;
+    uintptr_t page = kernel_arena.Alloc(PAGE_SIZE, PAGE_SIZE);
+    size_t frame = frames_alloc();
+    if (page == VMEM_FAILED || frame == SIZE_MAX) {
+        PANIC("Unable to grow the kernel virtual address arena.\n");
+    }
+    paging_map_page(VADDR(page), FRAME_TO_PHYS(frame));
+    kernel_arena.AddSegments((void *)page, PAGE_SIZE);
+}
+
+void map_kernel_page(virtual_address_t vaddr, phys_addr_t paddr, page_cache_t cache, mmu_gather_t *tlb) {
+    mutex_lock(&mutex_paging);
+    // Fixed mappings that land inside the arena take their addresses out of
+    // it. If the address is already in use the page is either mapped the
+    // same way already or paging_map_page() will complain about it.
+    if (vaddr.val >= PAGE_ALIGN_UP(KERNEL_END) && vaddr.val < KERNEL_ARENA_END) {
+        paging_refill_arena();
+        kernel_arena.Reserve(vaddr.val, PAGE_SIZE);
+    }
+    paging_map_page(vaddr, paddr, cache, tlb);
+    mutex_unlock(&mutex_paging);
 }
 
-void map_kernel_page(virtual_address_t vaddr, uint32_t paddr) {
+static void paging_map_page(virtual_address_t vaddr, phys_addr_t paddr, page_cache_t cache, mmu_gather_t *tlb) {
     // Set the page directory entry (pde) and page table entry (pte)
     uint32_t pde = vaddr.page_dir_index;
     uint32_t pte = vaddr.page_table_index;
@@ -117,13 +1012,26 @@ void map_kernel_page(virtual_address_t vaddr, uint32_t paddr) {
     if (vaddr.page_offset != 0) {
         PANIC("Attempted to map a non-page-aligned virtual address.\n");
     }
-    page_table_entry *entry = &(page_tables[pde].pages[pte]);
+    if (page_dir_phys[pde].page_size) {
+        // covered by a large page, which has to map it the same way
+        if (page_dir_phys[pde].table_addr + (vaddr.val & ~LARGE_PAGE_ALIGN) / PAGE_SIZE == paddr >> 12) {
+            return;
+        }
+        PANIC("Attempted to map a page inside a differently mapped large page.\n");
+    }
+    page_table_entry *entry = &(paging_table(pde)->pages[pte]);
     // Print a debug message to serial
-    debugf("map 0x%08x to 0x%08x, pde = 0x%08x, pte = 0x%08x\n", paddr, vaddr.val, pde, pte);
+    debugf("map frame 0x%05x to 0x%08x, pde = 0x%08x, pte = 0x%08x\n", (size_t)(paddr >> 12), vaddr.val, pde, pte);
     // If the page is already mapped into memory
     if (entry->present) {
         if (entry->frame == paddr >> 12) {
-            // this page was already mapped the same way
+            // this page was already mapped the same way, bar the memory type
+            if (entry->write_through != paging_cache_pwt(cache) ||
+                entry->cache_disable != paging_cache_pcd(cache)) {
+                entry->write_through = paging_cache_pwt(cache);
+                entry->cache_disable = paging_cache_pcd(cache);
+                paging_cache_changed(vaddr.val, tlb);
+            }
             return;
         }
 /*
@@ -143,43 +1051,45 @@ void map_kernel_page(virtual_address_t vaddr, uint32_t paddr) {
         PANIC("Attempted to map already mapped page.\n");
     }
     // Set the page information
-    page_tables[pde].pages[pte] = {
+    *entry = {
         .present = 1,           // The page is present
         .read_write = 1,        // The page has r/w permissions
         .usermode = 0,          // These are kernel pages
-        .write_through = 0,     // Disable write through
-        .cache_disable = 0,     // The page is cached
+        .write_through = paging_cache_pwt(cache), // Memory type, see PAT_VALUE
+        .cache_disable = paging_cache_pcd(cache),
         .accessed = 0,          // The page is unaccessed
         .dirty = 0,             // The page is clean
         .page_att_table = 0,    // The page has no attribute table
-        .global = 0,            // The page is local
+        .global = paging_is_global(vaddr.val), // Shared kernel pages survive CR3 reloads
+        .demand = 0,            // The page is backed
+        .cow = 0,               // The page is not shared
         .unused = 0,            // Ignored
-        .frame = paddr >> 12    // The last 20 bits are the frame
+        .frame = paddr >> 12    // Everything above the page offset is the frame
     };
-    // Set the associated bit in the bitmaps
-    mapped_mem.Set(paddr >> 12);
-    mapped_pages.Set(vaddr.val >> 12);
 }
 
 static void paging_map_early_mem() {
     debugf("==== MAP EARLY MEM ====\n");
-    virtual_address_t a;
-    for (a = VADDR(0); a.val < 0x100000; a.val += PAGE_SIZE) {
-        // identity map the early memory
-        map_kernel_page(a, a.val);
-    }
+    // identity map the early memory, and the early kernel after it which
+    // has to run with paging off to switch paging modes
+    map_kernel_range(0, 0, EARLY_KERNEL_END, PAGE_MAP_WRITE);
 }
 
 static void paging_map_hh_kernel() {
     debugf("==== MAP HH KERNEL ====\n");
-    virtual_address_t a;
-    for (a = VADDR(KERNEL_START); a.val < KERNEL_END; a.val += PAGE_SIZE) {
-        // map the higher-half kernel in
-        map_kernel_page(a, KADDR_TO_PHYS(a.val));
+    // Everything from the kernel base up to the end of the image belongs
+    // to the kernel, so the range may start at the large page boundary below
+    // the image to map whole chunks of it with a single entry.
+    uintptr_t start = KERNEL_START & LARGE_PAGE_ALIGN;
+    if (start < KERNEL_BASE) {
+        start = KERNEL_START;
     }
+    map_kernel_range(start, KADDR_TO_PHYS(start), KERNEL_END - start);
 }
 
 static inline void set_page_dir(size_t page_dir) {
+    // the fault tasks have to switch to the same directory
+    tss_set_page_dir(page_dir);
     asm volatile("mov %0, %%cr3" :: "b"(page_dir));
 }
 
@@ -190,6 +1100,9 @@ static inline void paging_enable() {
     // The most significant bit signifies whether to
     // enable or disable paging within control register 0.
     cr0 |= 0x80000000;
+    // Read-only pages must fault in kernel mode as well so that the
+    // shared zero page is copied on write.
+    cr0 |= CR0_WRITE_PROTECT;
     asm volatile("mov %0, %%cr0":: "b"(cr0));
 }
 
@@ -205,64 +1118,552 @@ static inline void paging_disable() {
     asm volatile("mov %0, %%cr0":: "b"(cr0));
 }
 
-/**
- * note: this can't find more than 32 sequential pages
- * @param seq the number of sequential pages to get
- */
-static uint32_t find_next_free_virt_addr(int seq) {
-    return mapped_pages.FindFirstRangeClear(seq);
-}
-
-static uint32_t find_next_free_phys_page() {
-    return mapped_mem.FindFirstBitClear();
+// Takes the paging lock, returns NULL with nothing left behind on failure
+static void* paging_new_pages(uint32_t page_count) {
+    mutex_lock(&mutex_paging);
+    paging_refill_arena();
+    paging_refill_fault_frames();
+    uintptr_t free_addr = VMEM_FAILED;
+    if (paging_pse && page_count >= LARGE_PAGE_FRAMES) {
+        // big allocations are aligned so that they can use large pages
+        free_addr = kernel_arena.Alloc(page_count * PAGE_SIZE, LARGE_PAGE_SIZE);
+    }
+    if (free_addr == VMEM_FAILED) {
+        free_addr = kernel_arena.Alloc(page_count * PAGE_SIZE, PAGE_SIZE);
+    }
+    if (free_addr == VMEM_FAILED) {
+        mutex_unlock(&mutex_paging);
+        return NULL;
+    }
+    for (uintptr_t page = free_addr; page < free_addr + page_count * PAGE_SIZE; page += PAGE_SIZE) {
+        if (!(page & ~LARGE_PAGE_ALIGN) && page + LARGE_PAGE_SIZE <= free_addr + page_count * PAGE_SIZE) {
+            // buddy blocks of the largest order are 4 MiB aligned
+            size_t run = paging_pse ? frames_alloc_contiguous(LARGE_PAGE_FRAMES) : SIZE_MAX;
+            if (run != SIZE_MAX) {
+                if (paging_map_large_page(VADDR(page), FRAME_TO_PHYS(run))) {
+                    page += LARGE_PAGE_SIZE - PAGE_SIZE;
+                    continue;
+                }
+                frames_free_contiguous(run, LARGE_PAGE_FRAMES);
+            }
+        }
+        size_t phys_page_idx = frames_alloc();
+        if (phys_page_idx == SIZE_MAX) {
+            // out of frames, so give back what was mapped so far
+            mmu_gather_t tlb;
+            mmu_gather_init(&tlb);
+            paging_unmap_range(&tlb, free_addr, page);
+            mmu_gather_finish(&tlb);
+            kernel_arena.Free(free_addr, page_count * PAGE_SIZE);
+            mutex_unlock(&mutex_paging);
+            return NULL;
+        }
+        paging_map_page(VADDR(page), FRAME_TO_PHYS(phys_page_idx));
+    }
+    mutex_unlock(&mutex_paging);
+    return (void *)free_addr;
 }
 
 /**
  * map in a new page. if you request less than one page, you will get exactly one page
  */
 void* get_new_page(uint32_t size) {
+    uint32_t page_count = (size / PAGE_SIZE) + 1;
+    void *pages = paging_new_pages(page_count);
+    // Caches may be holding on to enough memory, but the reclaim task
+    // did not get to it in time
+    if (pages == NULL && reclaim_pages(page_count) > 0) {
+        pages = paging_new_pages(page_count);
+    }
+    return pages;
+}
+
+void* get_demand_page(uint32_t size) {
     mutex_lock(&mutex_paging);
     uint32_t page_count = (size / PAGE_SIZE) + 1;
-    uint32_t free_idx = find_next_free_virt_addr(page_count);
-    if (free_idx == SIZE_MAX) return NULL;
-    for (uint32_t i = free_idx; i < free_idx + page_count; i++) {
-        uint32_t phys_page_idx = find_next_free_phys_page();
-        if (phys_page_idx == SIZE_MAX) return NULL;
-        map_kernel_page(VADDR((uint32_t)i * PAGE_SIZE), phys_page_idx * PAGE_SIZE);
+    paging_refill_arena();
+    paging_refill_fault_frames();
+    uintptr_t free_addr = kernel_arena.Alloc(page_count * PAGE_SIZE, PAGE_SIZE);
+    if (free_addr == VMEM_FAILED) {
+        mutex_unlock(&mutex_paging);
+        return NULL;
+    }
+    // Nothing is mapped yet, the entries only remember that the
+    // pages should be backed once they're touched.
+    paging_demand_run(free_addr, free_addr + page_count * PAGE_SIZE);
+    mutex_unlock(&mutex_paging);
+    return (void *)free_addr;
+}
+
+// Called with the paging lock held
+static void paging_demand_run(uintptr_t start, uintptr_t end) {
+    for (uintptr_t page = start; page < end; page += PAGE_SIZE) {
+        page_table_entry_t *entry = paging_get_entry(page);
+        *entry = { /* Zero */ };
+        entry->demand = 1;
+    }
+}
+
+void* resize_page(void *page, uint32_t old_size, uint32_t new_size) {
+    uintptr_t start = (uintptr_t)page;
+    size_t old_bytes = (old_size / PAGE_SIZE + 1) * PAGE_SIZE;
+    size_t new_bytes = (new_size / PAGE_SIZE + 1) * PAGE_SIZE;
+    if (new_bytes == old_bytes) {
+        return page;
+    }
+    mutex_lock(&mutex_paging);
+    paging_refill_arena();
+    paging_refill_fault_frames();
+    if (new_bytes < old_bytes) {
+        // the tail goes back like any other freed pages, after breaking
+        // up a large page that is only partly cut off
+        uintptr_t cut = start + new_bytes;
+        if ((cut & ~LARGE_PAGE_ALIGN) && page_dir_phys[VADDR(cut).page_dir_index].page_size &&
+            !paging_split_large_page(VADDR(cut).page_dir_index)) {
+            mutex_unlock(&mutex_paging);
+            return NULL;
+        }
+        mmu_gather_t tlb;
+        mmu_gather_init(&tlb);
+        paging_unmap_range(&tlb, start + new_bytes, start + old_bytes);
+        mmu_gather_finish(&tlb);
+        kernel_arena.Free(start + new_bytes, old_bytes - new_bytes);
+        mutex_unlock(&mutex_paging);
+        return page;
+    }
+    // Grow in place if nobody holds the addresses right behind the pages
+    uintptr_t tail = start + old_bytes;
+    size_t grow = new_bytes - old_bytes;
+    if (tail + grow > tail && tail + grow <= KERNEL_ARENA_END && kernel_arena.Reserve(tail, grow)) {
+        paging_demand_run(tail, tail + grow);
+        mutex_unlock(&mutex_paging);
+        return page;
+    }
+    // Large pages keep their alignment so that they move as a whole
+    uintptr_t moved = VMEM_FAILED;
+    if (paging_pse && !(start & ~LARGE_PAGE_ALIGN) && old_bytes >= LARGE_PAGE_SIZE) {
+        moved = kernel_arena.Alloc(new_bytes, LARGE_PAGE_SIZE);
+    }
+    if (moved == VMEM_FAILED) {
+        moved = kernel_arena.Alloc(new_bytes, PAGE_SIZE);
+    }
+    if (moved == VMEM_FAILED) {
+        mutex_unlock(&mutex_paging);
+        return NULL;
+    }
+    // Large pages that cannot land on a directory entry of their own are
+    // broken up before anything moves
+    for (size_t offset = 0; offset < old_bytes; offset += PAGE_SIZE) {
+        uint32_t src_idx = VADDR(start + offset).page_dir_index;
+        if (!page_dir_phys[src_idx].page_size) {
+            continue;
+        }
+        uint32_t dst_idx = VADDR(moved + offset).page_dir_index;
+        if (((moved + offset) & ~LARGE_PAGE_ALIGN) || !paging_table_empty(dst_idx)) {
+            if (!paging_split_large_page(src_idx)) {
+                kernel_arena.Free(moved, new_bytes);
+                mutex_unlock(&mutex_paging);
+                return NULL;
+            }
+        }
+        offset = ((start + offset) & LARGE_PAGE_ALIGN) + LARGE_PAGE_SIZE - PAGE_SIZE - start;
+    }
+    // Otherwise the frames move to the new addresses, only the entries
+    // are copied and the old ones are flushed in one batch
+    mmu_gather_t tlb;
+    mmu_gather_init(&tlb);
+    for (size_t offset = 0; offset < old_bytes; offset += PAGE_SIZE) {
+        uint32_t src_idx = VADDR(start + offset).page_dir_index;
+        if (page_dir_phys[src_idx].page_size) {
+            paging_move_large_page(src_idx, VADDR(moved + offset).page_dir_index);
+            mmu_gather_page(&tlb, start + offset);
+            offset += LARGE_PAGE_SIZE - PAGE_SIZE;
+            continue;
+        }
+        page_table_entry_t *src = paging_find_entry(start + offset);
+        page_table_entry_t *dst = paging_get_entry(moved + offset);
+        *dst = *src;
+        dst->global = paging_is_global(moved + offset);
+        if (src->present) {
+            mmu_gather_page(&tlb, start + offset);
+        }
+        *src = { /* Zero */ };
     }
+    paging_demand_run(moved + old_bytes, moved + new_bytes);
+    mmu_gather_finish(&tlb);
+    kernel_arena.Free(start, old_bytes);
     mutex_unlock(&mutex_paging);
-    return (void *)(free_idx * PAGE_SIZE);
+    return (void *)moved;
 }
 
 void free_page(void *page, uint32_t size) {
+    mmu_gather_t tlb;
+    mmu_gather_init(&tlb);
     mutex_lock(&mutex_paging);
     uint32_t page_count = (size / PAGE_SIZE) + 1;
-    uint32_t page_index = (uint32_t)page >> 12;
-    for (uint32_t i = page_index; i < page_index + page_count; i++) {
-        // TODO: need locking here (maybe make a paging lock)
-        mapped_pages.Clear(i);
-        // how much more UN-readable can we make this?? (pls, i need to know...)
-        //*(uint32_t*)((uint32_t)page_tables + i * 4) = 0;
-        // this is the same as the line above
-        page_table_entry_t *pte = &(page_tables[i / PAGE_ENTRIES].pages[i % PAGE_ENTRIES]);
-        // the frame field is actually the page frame's index
-        // basically it's frame 0, 1...(2^21-1)
-        mapped_mem.Clear(pte->frame);
-        // zero it out to unmap it
-        *pte = { /* Zero */ };
-        // clear that tlb
-        invalidate_page(page);
+    paging_unmap_range(&tlb, (uintptr_t)page, (uintptr_t)page + page_count * PAGE_SIZE);
+    // the frames may only be reused once they are out of the tlb
+    mmu_gather_finish(&tlb);
+    // hand the virtual addresses back to the arena
+    paging_refill_arena();
+    paging_refill_fault_frames();
+    kernel_arena.Free((uintptr_t)page, page_count * PAGE_SIZE);
+    mutex_unlock(&mutex_paging);
+}
+
+static void paging_init_stacks() {
+    // Carved out of the kernel arena the first time a stack is needed
+    paging_refill_arena();
+    stack_region = kernel_arena.Alloc(KERNEL_STACK_REGION_SIZE, PAGE_SIZE);
+    if (stack_region == VMEM_FAILED) {
+        PANIC("Unable to reserve the kernel stack region.\n");
     }
+    stack_arena = VmemArena(PAGE_SIZE);
+    stack_arena.AddSegments(stack_segments, sizeof(stack_segments));
+    stack_arena.Add(stack_region, KERNEL_STACK_REGION_SIZE);
+}
+
+void* get_new_stack(uint32_t max_size) {
+    mutex_lock(&mutex_paging);
+    if (stack_region == 0) {
+        paging_init_stacks();
+    }
+    paging_refill_fault_frames();
+    uint32_t size = PAGE_ALIGN_UP(max_size);
+    // The guard page below the stack is left empty so that running off
+    // the end faults instead of trampling whatever lies below
+    uintptr_t guard = size ? stack_arena.Alloc(size + PAGE_SIZE, PAGE_SIZE) : VMEM_FAILED;
+    if (guard == VMEM_FAILED) {
+        mutex_unlock(&mutex_paging);
+        return NULL;
+    }
+    *paging_get_entry(guard) = { /* Zero */ };
+    uintptr_t top = guard + PAGE_SIZE + size;
+    for (uintptr_t page = guard + PAGE_SIZE; page < top; page += PAGE_SIZE) {
+        page_table_entry_t *entry = paging_get_entry(page);
+        *entry = { /* Zero */ };
+        entry->demand = 1;
+    }
+    // The top page is about to be written anyway
+    size_t frame = frames_alloc();
+    if (frame == SIZE_MAX) {
+        stack_arena.Free(guard, size + PAGE_SIZE);
+        mutex_unlock(&mutex_paging);
+        return NULL;
+    }
+    paging_map_page(VADDR(top - PAGE_SIZE), FRAME_TO_PHYS(frame));
+    mem_stats_add(MEM_OWNER_STACKS, 1);
+    mutex_unlock(&mutex_paging);
+    return (void *)top;
+}
+
+void free_stack(void *top, uint32_t max_size) {
+    mutex_lock(&mutex_paging);
+    uint32_t size = PAGE_ALIGN_UP(max_size);
+    uintptr_t guard = (uintptr_t)top - size - PAGE_SIZE;
+    // only the pages the stack grew into were ever backed
+    mmu_gather_t tlb;
+    mmu_gather_init(&tlb);
+    mem_stats_sub(MEM_OWNER_STACKS, paging_unmap_range(&tlb, guard + PAGE_SIZE, (uintptr_t)top));
+    mmu_gather_finish(&tlb);
+    stack_arena.Free(guard, size + PAGE_SIZE);
     mutex_unlock(&mutex_paging);
 }
 
 bool page_is_present(size_t addr) {
-    // Convert the address into an index and
-    // check whether the page is in the bitmap
-    return mapped_pages.Get(addr >> 12);
+    // Look the page up in the kernel page tables
+    if (page_dir_phys[VADDR(addr).page_dir_index].page_size) return true;
+    page_table_entry_t *entry = paging_find_entry(addr);
+    return entry != NULL && entry->present;
+}
+
+size_t page_frame(void *addr) {
+    uintptr_t page = (uintptr_t)addr;
+    page_directory_entry_t pde = page_dir_phys[VADDR(page).page_dir_index];
+    if (pde.present && pde.page_size) {
+        return pde.table_addr + (page & ~LARGE_PAGE_ALIGN) / PAGE_SIZE;
+    }
+    page_table_entry_t *entry = paging_find_entry(page);
+    return entry != NULL && entry->present ? entry->frame : SIZE_MAX;
+}
+
+void paging_get_arena_stats(size_t *free, size_t *largest_free) {
+    mutex_lock(&mutex_paging);
+    *free = kernel_arena.FreeSize();
+    *largest_free = kernel_arena.LargestFree();
+    mutex_unlock(&mutex_paging);
 }
 
 // TODO: maybe enforce access control here in the future
 uint32_t get_phys_page_dir() {
     return page_dir_addr;
 }
+
+static inline bool paging_is_private(uintptr_t addr) {
+    return private_region != 0 && addr - private_region < ADDRESS_SPACE_PRIVATE_SIZE;
+}
+
+static inline bool paging_is_global(uintptr_t addr) {
+    // private mappings differ between address spaces
+    return addr >= KERNEL_BASE && !paging_is_private(addr);
+}
+
+static inline size_t paging_irq_save() {
+    size_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r"(flags) :: "memory");
+    return flags;
+}
+
+static inline void paging_irq_restore(size_t flags) {
+    asm volatile("push %0; popf" :: "r"(flags) : "memory", "cc");
+}
+
+static void paging_sync_pde(uint32_t pd_idx) {
+    // Called with the paging lock held whenever a kernel directory entry
+    // changes. Page tables are shared, but the entries pointing at them
+    // (and large pages) are copied into every address space.
+    if (pd_idx >= PAGING_RECURSIVE_FIRST || paging_is_private(pd_idx * LARGE_PAGE_SIZE)) {
+        return;
+    }
+    for (address_space_t *space = address_spaces; space != NULL; space = space->next) {
+        space->dir[pd_idx] = page_dir_phys[pd_idx];
+    }
+}
+
+uintptr_t address_space_private_base() {
+    return private_region;
+}
+
+address_space_t *address_space_create() {
+    mutex_lock(&mutex_paging);
+    if (private_region == 0) {
+        // The window is taken out of the kernel arena once. Its entries in
+        // the kernel page directory stay empty.
+        paging_refill_arena();
+        private_region = kernel_arena.Alloc(ADDRESS_SPACE_PRIVATE_SIZE, LARGE_PAGE_SIZE);
+        if (private_region == VMEM_FAILED) {
+            PANIC("Unable to reserve the address space private window.\n");
+        }
+    }
+    mutex_unlock(&mutex_paging);
+    if (space_cache == NULL) {
+        space_cache = kmem_cache_create("address_space", sizeof(address_space_t), 0, NULL);
+    }
+    address_space_t *space = space_cache ? (address_space_t *)kmem_cache_alloc(space_cache) : NULL;
+    page_directory_entry_t *dir = (page_directory_entry_t *)get_new_page(PAGE_DIR_SIZE - 1);
+    if (space != NULL) {
+        *space = { /* Zero */ };
+    }
+    if (space == NULL || dir == NULL || !address_space_set_dir(space, dir)) {
+        if (dir) free_page(dir, PAGE_DIR_SIZE - 1);
+        if (space) kmem_cache_free(space_cache, space);
+        return NULL;
+    }
+    space->refs = 1;
+    mutex_lock(&mutex_paging);
+    // share every kernel page table, leave the private window empty
+    // and point the recursive entries at the new directory
+    for (uint32_t i = 0; i < PAGING_RECURSIVE_FIRST; i++) {
+        if (paging_is_private(i * LARGE_PAGE_SIZE)) {
+            dir[i] = { /* Zero */ };
+        } else {
+            dir[i] = page_dir_phys[i];
+        }
+    }
+    for (uint32_t i = 0; i < PAGING_RECURSIVE_ENTRIES; i++) {
+        dir[PAGING_RECURSIVE_FIRST + i] = page_dir_phys[PAGING_RECURSIVE_FIRST + i];
+        dir[PAGING_RECURSIVE_FIRST + i].table_addr = page_frame(&dir[i * PAGE_ENTRIES]);
+    }
+    space->next = address_spaces;
+    address_spaces = space;
+    mutex_unlock(&mutex_paging);
+    return space;
+}
+
+void address_space_get(address_space_t *space) {
+    mutex_lock(&mutex_spaces);
+    space->refs++;
+    mutex_unlock(&mutex_spaces);
+}
+
+void address_space_release(address_space_t *space) {
+    mutex_lock(&mutex_spaces);
+    bool last = --space->refs == 0;
+    if (last) {
+        address_space_destroy(space);
+    }
+    mutex_unlock(&mutex_spaces);
+}
+
+static void address_space_destroy(address_space_t *space) {
+    size_t cr3;
+    asm volatile("mov %%cr3, %0" : "=r"(cr3));
+    if (cr3 == space->dir_phys) {
+        PANIC("Attempted to destroy the current address space.\n");
+    }
+    mutex_lock(&mutex_paging);
+    for (address_space_t **link = &address_spaces; *link != NULL; link = &(*link)->next) {
+        if (*link == space) {
+            *link = space->next;
+            break;
+        }
+    }
+    mutex_unlock(&mutex_paging);
+    uint32_t zero_frame = KADDR_TO_PHYS((uint32_t)zero_page) >> 12;
+    mmu_gather_t tlb;
+    mmu_gather_init(&tlb);
+    for (size_t i = 0; i < ADDRESS_SPACE_TABLES; i++) {
+        page_table_t *table = space->tables[i];
+        if (table == NULL) continue;
+        for (size_t j = 0; j < PAGE_ENTRIES; j++) {
+            page_table_entry_t entry = table->pages[j];
+            if (!entry.present || entry.frame == zero_frame) continue;
+            // frames still mapped by another address space stay around
+            if (!frame_unshare(entry.frame)) {
+                mmu_gather_frames(&tlb, entry.frame, 1);
+            }
+        }
+        free_page(table, PAGE_SIZE - 1);
+        mem_stats_sub(MEM_OWNER_PAGE_TABLES, 1);
+    }
+    mmu_gather_finish(&tlb);
+#ifdef PAGING_PAE
+    frames_free(PHYS_TO_FRAME(space->dir_phys));
+    mem_stats_sub(MEM_OWNER_PAGE_TABLES, 1);
+#endif
+    free_page(space->dir, PAGE_DIR_SIZE - 1);
+    mem_stats_sub(MEM_OWNER_PAGE_TABLES, PAGE_DIR_SIZE / PAGE_SIZE);
+    kmem_cache_free(space_cache, space);
+}
+
+// Fills in what CR3 is loaded with for a new directory
+static bool address_space_set_dir(address_space_t *space, page_directory_entry_t *dir) {
+#ifdef PAGING_PAE
+    // CR3 only holds 32 bits, so the pointer table has to sit below 4 GiB
+    size_t ptrs_frame = frames_alloc_low();
+    uint64_t *ptrs = ptrs_frame != SIZE_MAX ? (uint64_t *)kmap_temp(FRAME_TO_PHYS(ptrs_frame)) : NULL;
+    if (ptrs == NULL) {
+        if (ptrs_frame != SIZE_MAX) frames_free(ptrs_frame);
+        return false;
+    }
+    memset(ptrs, 0, PAGE_SIZE);
+    for (uint32_t i = 0; i < PAGE_DIR_POINTERS; i++) {
+        ptrs[i] = FRAME_TO_PHYS(page_frame(&dir[i * PAGE_ENTRIES])) | PAGE_ENTRY_PRESENT;
+    }
+    kunmap_temp(ptrs);
+    frame_set_flags(ptrs_frame, FRAME_PAGE_TABLE);
+    mem_stats_add(MEM_OWNER_PAGE_TABLES, 1);
+    space->dir_phys = FRAME_TO_PHYS(ptrs_frame);
+#else
+    space->dir_phys = FRAME_TO_PHYS(page_frame(dir));
+#endif
+    for (uint32_t i = 0; i < PAGING_RECURSIVE_ENTRIES; i++) {
+        frame_set_flags(page_frame(&dir[i * PAGE_ENTRIES]), FRAME_PAGE_TABLE);
+    }
+    mem_stats_add(MEM_OWNER_PAGE_TABLES, PAGE_DIR_SIZE / PAGE_SIZE);
+    space->dir = dir;
+    return true;
+}
+
+// Called with the address space lock held
+static page_table_t *address_space_table(address_space_t *space, uintptr_t vaddr) {
+    size_t idx = (vaddr - private_region) / LARGE_PAGE_SIZE;
+    if (space->tables[idx] != NULL) {
+        return space->tables[idx];
+    }
+    page_table_t *table = (page_table_t *)get_new_page(PAGE_SIZE - 1);
+    if (table == NULL) {
+        return NULL;
+    }
+    memset(table, 0, PAGE_SIZE);
+    mem_stats_add(MEM_OWNER_PAGE_TABLES, 1);
+    frame_set_flags(page_frame(table), FRAME_PAGE_TABLE);
+    space->tables[idx] = table;
+    space->dir[VADDR(vaddr).page_dir_index] = {
+        .present = 1,
+        .read_write = 1,
+        .usermode = 0,
+        .write_through = 0,
+        .cache_disable = 0,
+        .accessed = 0,
+        .ignored_a = 0,
+        .page_size = 0,
+        .global = 0,
+        .ignored_b = 0,
+        .table_addr = page_frame(table)
+    };
+    return table;
+}
+
+bool address_space_map(address_space_t *space, uintptr_t vaddr, size_t size) {
+    if ((vaddr & ~PAGE_ALIGN) || !paging_is_private(vaddr) ||
+        size > ADDRESS_SPACE_PRIVATE_SIZE - (vaddr - private_region)) {
+        return false;
+    }
+    mutex_lock(&mutex_spaces);
+    for (uintptr_t page = vaddr; page < vaddr + size; page += PAGE_SIZE) {
+        page_table_t *table = address_space_table(space, page);
+        if (table == NULL) {
+            mutex_unlock(&mutex_spaces);
+            return false;
+        }
+        page_table_entry_t *entry = &table->pages[VADDR(page).page_table_index];
+        if (!entry->present && !entry->demand) {
+            entry->demand = 1;
+        }
+    }
+    mutex_unlock(&mutex_spaces);
+    return true;
+}
+
+address_space_t *address_space_clone(address_space_t *src) {
+    address_space_t *dst = address_space_create();
+    if (dst == NULL) {
+        return NULL;
+    }
+    size_t cr3;
+    asm volatile("mov %%cr3, %0" : "=r"(cr3));
+    bool current = cr3 == src->dir_phys;
+    uint32_t zero_frame = KADDR_TO_PHYS((uint32_t)zero_page) >> 12;
+    bool cloned = true;
+    mmu_gather_t tlb;
+    mmu_gather_init(&tlb);
+    mutex_lock(&mutex_spaces);
+    for (size_t i = 0; i < ADDRESS_SPACE_TABLES && cloned; i++) {
+        if (src->tables[i] == NULL) continue;
+        uintptr_t base = private_region + i * LARGE_PAGE_SIZE;
+        page_table_t *table = address_space_table(dst, base);
+        if (table == NULL) {
+            cloned = false;
+            break;
+        }
+        for (size_t j = 0; j < PAGE_ENTRIES; j++) {
+            // Other tasks of the source may fault on the entry meanwhile
+            size_t flags = paging_irq_save();
+            page_table_entry_t *entry = &src->tables[i]->pages[j];
+            if (entry->present && entry->frame != zero_frame) {
+                if (!frame_share(entry->frame)) {
+                    paging_irq_restore(flags);
+                    cloned = false;
+                    break;
+                }
+                // both sides get a copy of their own on the first write
+                if (entry->read_write) {
+                    entry->read_write = 0;
+                    entry->cow = 1;
+                    if (current) mmu_gather_page(&tlb, base + j * PAGE_SIZE);
+                }
+            }
+            table->pages[j] = *entry;
+            paging_irq_restore(flags);
+        }
+    }
+    mutex_unlock(&mutex_spaces);
+    // the source may not write through stale writable entries anymore
+    mmu_gather_finish(&tlb);
+    if (!cloned) {
+        address_space_release(dst);
+        return NULL;
+    }
+    return dst;
+}
@@ -30,12 +30,39 @@ extern "C" void invalidate_page(void *page_addr);
 #define PAGE_ENTRY_PRESENT  0x1
 #define PAGE_ENTRY_RW       0x2
 #define PAGE_ENTRY_ACCESS   0x20
+#ifdef PAGING_PAE
+// PAE (make PAGING=pae): 64-bit entries, 512 to a table, and four page
+// directories selected by a pointer table. The four directories are kept
+// next to each other and treated as a single one of 2048 entries.
+#define PHYS_ADDRESS_LIMIT  0x1000000000ULL
+#define PAGE_ENTRIES        512
+#define PAGE_DIR_ENTRIES    2048
+#define PAGE_DIR_POINTERS   4
+#define LARGE_PAGE_SIZE     0x200000
+#define LARGE_PAGE_ALIGN    0xffe00000
+#else
+#define PHYS_ADDRESS_LIMIT  ADDRESS_SPACE_SIZE
 #define PAGE_ENTRIES        1024
-#define PAGE_TABLE_SIZE     (sizeof(uint32)*PAGE_ENTRIES)
+#define PAGE_DIR_ENTRIES    1024
+#define LARGE_PAGE_SIZE     0x400000
+#define LARGE_PAGE_ALIGN    0xffc00000
+#endif
+#define PAGE_TABLE_SIZE     (sizeof(page_table_entry_t)*PAGE_ENTRIES)
+#define PAGE_DIR_SIZE       (sizeof(page_directory_entry_t)*PAGE_DIR_ENTRIES)
 #define PAGES_PER_KB(kb)    (PAGE_ALIGN_UP((kb) * 1024) / PAGE_SIZE)
 #define PAGES_PER_MB(mb)    (PAGE_ALIGN_UP((mb) * 1024 * 1024) / PAGE_SIZE)
 #define PAGES_PER_GB(gb)    (PAGE_ALIGN_UP((gb) * 1024 * 1024 * 1024) / PAGE_SIZE)
 #define VADDR(ADDR)         ((virtual_address_t){ .val = (ADDR) })
+#define KADDR_TO_PHYS(addr) ((addr) - KERNEL_BASE)
+
+/**
+ * @brief Physical address, wide enough for anything the page tables can map.
+ */
+#ifdef PAGING_PAE
+typedef uint64_t phys_addr_t;
+#else
+typedef uint32_t phys_addr_t;
+#endif
 
 /**
  * @brief Provides a structure for defining the necessary fields
@@ -44,9 +71,15 @@ extern "C" void invalidate_page(void *page_addr);
 typedef union virtual_address
 {
     struct {
+#ifdef PAGING_PAE
+        uint32_t page_offset       : 12;  // Page offset address
+        uint32_t page_table_index  : 9;   // Page table entry
+        uint32_t page_dir_index    : 11;  // Page directory entry (pointer table index in the top two bits)
+#else
         uint32_t page_offset       : 12;  // Page offset address
         uint32_t page_table_index  : 10;  // Page table entry
         uint32_t page_dir_index    : 10;  // Page directory entry
+#endif
     };
     uint32_t val;
 } virtual_address_t;
@@ -56,6 +89,25 @@ typedef union virtual_address
  * Intel Developer Manual Vol. 3a p. 4-12
  *
  */
+#ifdef PAGING_PAE
+typedef struct page_table_entry
+{
+    uint64_t present            : 1;  // Page present in memory
+    uint64_t read_write         : 1;  // Read-only if clear, readwrite if set
+    uint64_t usermode           : 1;  // Supervisor level only if clear
+    uint64_t write_through      : 1;  // Page level write through
+    uint64_t cache_disable      : 1;  // Disables TLB caching of page entry
+    uint64_t accessed           : 1;  // Has the page been accessed since last refresh?
+    uint64_t dirty              : 1;  // Has the page been written to since last refresh?
+    uint64_t page_att_table     : 1;  // Page attribute table (memory cache control)
+    uint64_t global             : 1;  // Prevents the TLB from updating the address
+    uint64_t demand             : 1;  // Backed by a zeroed frame on first touch (OS defined)
+    uint64_t cow                : 1;  // Shared read-only until written, then copied (OS defined)
+    uint64_t unused             : 1;  // Amalgamation of unused and reserved bits
+    uint64_t frame              : 52; // Frame address (shifted right 12 bits), the top bits
+                                      // (reserved and execute disable) stay clear
+} page_table_entry_t;
+#else
 typedef struct page_table_entry
 {
     uint32_t present            : 1;  // Page present in memory
@@ -67,9 +119,12 @@ typedef struct page_table_entry
     uint32_t dirty              : 1;  // Has the page been written to since last refresh?
     uint32_t page_att_table     : 1;  // Page attribute table (memory cache control)
     uint32_t global             : 1;  // Prevents the TLB from updating the address
-    uint32_t unused             : 3;  // Amalgamation of unused and reserved bits
+    uint32_t demand             : 1;  // Backed by a zeroed frame on first touch (OS defined)
+    uint32_t cow                : 1;  // Shared read-only until written, then copied (OS defined)
+    uint32_t unused             : 1;  // Amalgamation of unused and reserved bits
     uint32_t frame              : 20; // Frame address (shifted right 12 bits)
 } page_table_entry_t;
+#endif
 
 /**
  * @brief Page table structure as defined in accordance to the
@@ -78,7 +133,7 @@ typedef struct page_table_entry
  */
 typedef struct page_table
 {
-   page_table_entry_t pages[1024];
+   page_table_entry_t pages[PAGE_ENTRIES];
 } page_table_t;
 
 /**
@@ -86,6 +141,23 @@ typedef struct page_table
  * Intel Developer Manual Vol. 3a p. 4-12
  *
  */
+#ifdef PAGING_PAE
+typedef struct page_directory_entry
+{
+    uint64_t present            : 1;  // Is the page present in physical memory?
+    uint64_t read_write         : 1;  // Is the page read/write or read-only?
+    uint64_t usermode           : 1;  // Can the page be accessed in usermode?
+    uint64_t write_through      : 1;  // Is write-through cache enabled?
+    uint64_t cache_disable      : 1;  // Can the page be cached?
+    uint64_t accessed           : 1;  // Has the page been accessed?
+    uint64_t ignored_a          : 1;  // Ignored
+    uint64_t page_size          : 1;  // Is the page 2 Mb (enabled) or 4 Kb (disabled)?
+    uint64_t global             : 1;  // Survives CR3 reloads (2 Mb pages only)
+    uint64_t ignored_b          : 3;  // Ignored
+    uint64_t table_addr         : 52; // Physical address of the table, the top bits
+                                      // (reserved and execute disable) stay clear
+} page_directory_entry_t;
+#else
 typedef struct page_directory_entry
 {
     uint32_t present            : 1;  // Is the page present in physical memory?
@@ -96,9 +168,14 @@ typedef struct page_directory_entry
     uint32_t accessed           : 1;  // Has the page been accessed?
     uint32_t ignored_a          : 1;  // Ignored
     uint32_t page_size          : 1;  // Is the page 4 Mb (enabled) or 4 Kb (disabled)?
-    uint32_t ignored_b          : 4;  // Ignored
+    uint32_t global             : 1;  // Survives CR3 reloads (4 Mb pages only)
+    uint32_t ignored_b          : 3;  // Ignored
     uint32_t table_addr         : 20; // Physical address of the table
 } page_directory_entry_t;
+#endif
+
+static_assert(sizeof(page_table_entry_t) == sizeof(phys_addr_t), "Page table entries are as wide as physical addresses");
+static_assert(sizeof(page_directory_entry_t) == sizeof(phys_addr_t), "Page directory entries are as wide as physical addresses");
 
 /**
  * @brief Page directory contains pointers to all of the virtual memory addresses for the
@@ -108,11 +185,68 @@ typedef struct page_directory_entry
  */
 typedef struct page_directory
 {
-    page_table_t *tables[1024];                  // Pointers that Panix uses to access the pages in memory
-    page_directory_entry_t tablesPhysical[1024]; // Pointers that the Intel CPU uses to access pages in memory
+    page_table_t *tables[PAGE_DIR_ENTRIES];                  // Pointers that Panix uses to access the pages in memory
+    page_directory_entry_t tablesPhysical[PAGE_DIR_ENTRIES]; // Pointers that the Intel CPU uses to access pages in memory
     uint32_t physical_addr;                         // Physical address of this 4Kb aligned page table referenced by this entry
 } page_directory_t;
 
+/**
+ * @brief Memory types a kernel mapping can have, set up through the page
+ * attribute table. RAM is write-back, framebuffers are best mapped
+ * write-combining and device registers uncached.
+ *
+ */
+typedef enum page_cache {
+    PAGE_CACHE_WB,  // Write-back (default)
+    PAGE_CACHE_WC,  // Write-combining, uncached-minus without PAT support
+    PAGE_CACHE_UC,  // Uncached
+} page_cache_t;
+
+// Frames that can be mapped with kmap_temp() at the same time
+#define FIXMAP_SLOTS        16
+// Pages invalidated one by one before a gather flushes the whole TLB instead
+#define MMU_GATHER_PAGES    32
+// Frame runs a gather holds on to before it has to flush early
+#define MMU_GATHER_FRAMES   64
+
+/**
+ * @brief Collects the pages whose entries were cleared or changed so that
+ * the TLB is flushed once for all of them, and the frames they mapped so
+ * that they are only reused once no stale translation can reach them.
+ * Lives on the stack of whoever changes the mappings, see mmu_gather_init().
+ *
+ */
+typedef struct mmu_gather {
+    uintptr_t pages[MMU_GATHER_PAGES];  // Pages to invalidate
+    size_t page_count;
+    bool flush_all;                     // Too many pages, flush everything
+    bool write_back;                    // Memory types changed, write back caches
+    struct {
+        size_t first;                   // First frame of the run
+        size_t count;                   // Number of frames in the run
+    } frames[MMU_GATHER_FRAMES];        // Frames to free after the flush
+    size_t frame_count;
+} mmu_gather_t;
+
+// Every address space has a window of private mappings at the same place,
+// everything else (the whole kernel) is shared by reference
+#define ADDRESS_SPACE_PRIVATE_SIZE  (64 * 1024 * 1024)
+#define ADDRESS_SPACE_TABLES        (ADDRESS_SPACE_PRIVATE_SIZE / LARGE_PAGE_SIZE)
+
+/**
+ * @brief A page directory of its own. The kernel page tables are shared
+ * with every other address space, only the private window has tables of
+ * its own, which are allocated as they are needed.
+ *
+ */
+typedef struct address_space {
+    page_directory_entry_t *dir;                // Page directory (kernel virtual address)
+    uint32_t dir_phys;                          // What CR3 is loaded with, the page directory or its pointer table
+    page_table_t *tables[ADDRESS_SPACE_TABLES]; // Private page tables (kernel virtual addresses)
+    size_t refs;                                // Tasks running in the address space
+    struct address_space *next;                 // Every address space, to share kernel updates
+} address_space_t;
+
 /**
  * @brief Sets up the environment, page directories etc and enables paging.
  *
@@ -127,6 +261,52 @@ void paging_init(uint32_t num_pages);
  */
 void* get_new_page(uint32_t size);
 
+/**
+ * @brief Reserves pages that are only backed by memory once they are
+ * touched. The first write to a page maps a zeroed frame, while reads
+ * map a shared zero page which is copied on write. Pages are returned
+ * with free_page() like any other.
+ *
+ * @param size Page size in bytes
+ * @return void* Page memory address or NULL if out of address space
+ */
+void* get_demand_page(uint32_t size);
+
+/**
+ * @brief Resizes pages from get_demand_page() or get_new_page() without
+ * copying them. The pages grow in place when the addresses behind them are
+ * free, otherwise their frames are moved to a new range by rewriting the
+ * page table entries. Large pages move as a whole when the new range lines
+ * up with them and are broken up into page tables otherwise. Added pages
+ * are backed on demand, pages cut off are freed.
+ *
+ * @param page Pages as returned by get_demand_page(), get_new_page() or resize_page()
+ * @param old_size Size the pages were allocated with
+ * @param new_size Size the pages should have, same convention as old_size
+ * @return void* New page address or NULL if out of address space or
+ * frames for page tables, in which case the old pages are left untouched
+ */
+void* resize_page(void *page, uint32_t old_size, uint32_t new_size);
+
+/**
+ * @brief Allocates a kernel stack. The stack reserves max_size bytes of
+ * address space with an unmapped guard page below it, but only the top
+ * page is backed up front. Pages are committed as the stack grows down,
+ * and running into the guard page panics.
+ *
+ * @param max_size Largest size the stack may grow to in bytes
+ * @return void* Top of the stack (its initial stack pointer) or NULL
+ */
+void* get_new_stack(uint32_t max_size);
+
+/**
+ * @brief Frees a stack allocated by get_new_stack().
+ *
+ * @param top Top of the stack as returned by get_new_stack()
+ * @param max_size Size the stack was allocated with
+ */
+void  free_stack(void *top, uint32_t max_size);
+
 /**
  * @brief Frees pages starting at a given page address.
  *
@@ -135,6 +315,40 @@ void* get_new_page(uint32_t size);
  */
 void  free_page(void *page, uint32_t size);
 
+/**
+ * @brief Flushes the whole TLB, including the global kernel entries that
+ * survive CR3 reloads. Only needed when many global mappings change at
+ * once, single pages can be flushed with invalidate_page().
+ *
+ */
+void paging_flush_tlb();
+
+/**
+ * @brief Starts a batch of mapping changes.
+ *
+ * @param tlb Gather to be initialized
+ */
+void mmu_gather_init(mmu_gather_t *tlb);
+
+/**
+ * @brief Unmaps every page touched by a range of kernel virtual addresses.
+ * The frames are queued on the gather and freed by mmu_gather_finish().
+ * The addresses themselves stay reserved.
+ *
+ * @param tlb Gather collecting the cleared entries
+ * @param addr Start of the range
+ * @param size Size of the range in bytes
+ */
+void mmu_gather_unmap(mmu_gather_t *tlb, void *addr, uint32_t size);
+
+/**
+ * @brief Flushes the TLB for every page collected by the gather (all of
+ * it past MMU_GATHER_PAGES pages) and then frees the queued frames.
+ *
+ * @param tlb Gather to be finished, it can be used again afterwards
+ */
+void mmu_gather_finish(mmu_gather_t *tlb);
+
 /**
  * @brief Checks whether an address is mapped into memory.
  *
@@ -144,6 +358,40 @@ void  free_page(void *page, uint32_t size);
  */
 bool page_is_present(size_t addr);
 
+/**
+ * @brief Gets how much kernel virtual address space is left.
+ *
+ * @param free Filled in with the free bytes
+ * @param largest_free Filled in with the size of the largest free range
+ */
+void paging_get_arena_stats(size_t *free, size_t *largest_free);
+
+/**
+ * @brief Maps a physical frame for a moment, e.g. to zero or copy it.
+ * One of FIXMAP_SLOTS reserved page table entries is filled in, nothing
+ * is allocated and no locks are taken, so the page fault task may use it
+ * too. Every mapping must be removed with kunmap_temp() soon after.
+ *
+ * @param paddr Physical address, the page offset is kept
+ * @return void* Virtual address of paddr or NULL if every slot is in use
+ */
+void *kmap_temp(phys_addr_t paddr);
+
+/**
+ * @brief Removes a mapping made by kmap_temp() with a single invlpg.
+ *
+ * @param addr Address returned by kmap_temp()
+ */
+void kunmap_temp(void *addr);
+
+/**
+ * @brief Looks up the frame behind a kernel virtual address.
+ *
+ * @param addr Kernel virtual address
+ * @return size_t Frame number or SIZE_MAX if nothing is mapped there
+ */
+size_t page_frame(void *addr);
+
 /**
  * @brief Gets the physical address of the current page directory.
  *
@@ -151,4 +399,122 @@ bool page_is_present(size_t addr);
  */
 uint32_t get_phys_page_dir();
 
-void map_kernel_page(virtual_address_t vaddr, uint32_t paddr);
+/**
+ * @brief Maps a 4 KiB page into kernel space. Mapping a page the same way
+ * again is allowed and changes its memory type if that differs.
+ *
+ * @param vaddr Virtual address (page aligned)
+ * @param paddr Physical address (page aligned)
+ * @param cache Memory type of the mapping
+ * @param tlb Gather that batches the flush when the memory type changes,
+ * or NULL to flush right away
+ */
+void map_kernel_page(virtual_address_t vaddr, phys_addr_t paddr, page_cache_t cache = PAGE_CACHE_WB,
+                     mmu_gather_t *tlb = NULL);
+
+/**
+ * @brief Maps a large page (LARGE_PAGE_SIZE, 4 MiB or 2 MiB with PAE)
+ * with a single page directory entry. This only works if the processor
+ * supports PSE or PAE, both addresses are aligned to the large page size
+ * and nothing is mapped with 4 KiB pages in that range yet. Otherwise
+ * nothing is mapped and the caller should fall back to map_kernel_page().
+ *
+ * @param vaddr Virtual address (large page aligned)
+ * @param paddr Physical address (large page aligned)
+ * @param cache Memory type of the mapping
+ * @param tlb Gather that batches the flush when the memory type changes,
+ * or NULL to flush right away
+ * @return true The large page is mapped
+ * @return false The range has to be mapped with 4 KiB pages
+ */
+bool map_kernel_large_page(virtual_address_t vaddr, phys_addr_t paddr, page_cache_t cache = PAGE_CACHE_WB,
+                           mmu_gather_t *tlb = NULL);
+
+// Flags for map_kernel_range()
+#define PAGE_MAP_WRITE      0x1     // The range is writable
+#define PAGE_MAP_LARGE      0x2     // Large pages may be used where alignment allows
+
+/**
+ * @brief Maps a physical region into kernel space. Every page touched by
+ * [vaddr, vaddr + size) is mapped to the matching page at paddr, so both
+ * addresses need the same offset into their page. Pages that are already
+ * mapped to the same frame are left alone apart from their memory type and
+ * write permission. Whole large page aligned chunks of the range take a single
+ * directory entry if PAGE_MAP_LARGE is given.
+ *
+ * @param vaddr Virtual address
+ * @param paddr Physical address
+ * @param size Size of the region in bytes
+ * @param flags PAGE_MAP_* flags
+ * @param cache Memory type of the mapping
+ * @param tlb Gather that batches the flush when existing entries change,
+ * or NULL to flush right away
+ * @return size_t Number of page table and directory entries written
+ */
+size_t map_kernel_range(uintptr_t vaddr, phys_addr_t paddr, size_t size,
+                        uint32_t flags = PAGE_MAP_WRITE | PAGE_MAP_LARGE,
+                        page_cache_t cache = PAGE_CACHE_WB, mmu_gather_t *tlb = NULL);
+
+/**
+ * @brief Removes a mapping made with map_kernel_range(). The frames are
+ * not freed since the caller never got them from the frame allocator.
+ *
+ * @param vaddr Virtual address
+ * @param size Size of the region in bytes
+ * @param tlb Gather that batches the flush, or NULL to flush right away
+ * @return size_t Number of page table and directory entries cleared
+ */
+size_t unmap_kernel_range(uintptr_t vaddr, size_t size, mmu_gather_t *tlb = NULL);
+
+/**
+ * @brief Returns where the private window of every address space starts.
+ * It is ADDRESS_SPACE_PRIVATE_SIZE bytes long.
+ *
+ * @return uintptr_t Start of the private window
+ */
+uintptr_t address_space_private_base();
+
+/**
+ * @brief Creates an address space with an empty private window.
+ *
+ * @return address_space_t* Address space (with one reference) or NULL
+ */
+address_space_t *address_space_create();
+
+/**
+ * @brief Clones an address space. Private pages are not copied, both
+ * address spaces map them read-only and whichever writes a page first
+ * gets a copy of its own. Only the private page tables are duplicated.
+ *
+ * @param src Address space to be cloned
+ * @return address_space_t* New address space (with one reference) or NULL
+ */
+address_space_t *address_space_clone(address_space_t *src);
+
+/**
+ * @brief Takes another reference to an address space.
+ *
+ * @param space Address space
+ */
+void address_space_get(address_space_t *space);
+
+/**
+ * @brief Drops a reference to an address space. The last one frees the
+ * private pages that are not shared anymore, the private page tables and
+ * the page directory. It may not be the current address space by then.
+ *
+ * @param space Address space
+ */
+void address_space_release(address_space_t *space);
+
+/**
+ * @brief Sets aside private pages that are backed by zeroed frames the
+ * first time they are touched.
+ *
+ * @param space Address space
+ * @param vaddr Start of the range (page aligned, inside the private window)
+ * @param size Size of the range in bytes
+ * @return true The pages are set aside
+ * @return false The range is outside the private window or out of memory
+ */
+bool address_space_map(address_space_t *space, uintptr_t vaddr, size_t size);
@@ -0,0 +1,125 @@
+/**
+ * @file reclaim.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Gives memory held by caches back when free frames run low
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <mem/reclaim.hpp>
+#include <mem/frames.hpp>
+#include <mem/slab.hpp>
+#include <mem/zero_pool.hpp>
+#include <lib/mutex.hpp>
+#include <sys/tasks.hpp>
+#include <dev/serial/rs232.hpp>
+
+static shrinker_t *shrinkers = NULL;
+static mutex_t mutex_shrinkers("shrinkers");
+static size_t watermark_low = RECLAIM_LOW_MIN;
+static size_t watermark_high = RECLAIM_LOW_MIN * RECLAIM_HIGH_FACTOR;
+static size_t reclaim_runs = 0;
+static size_t reclaimed = 0;
+
+// Pages waiting to be zeroed are the cheapest to give up, empty slabs next
+static shrinker_t zero_pool_shrinker = { "zero_pool", zero_pool_reclaimable, zero_pool_shrink, NULL };
+static shrinker_t slab_shrinker = { "slab", kmem_cache_reclaimable, kmem_cache_reap, NULL };
+
+// Function prototypes
+static size_t reclaim_scan(size_t pages);
+
+void reclaim_init()
+{
+    frames_stats_t stats;
+    frames_get_stats(&stats);
+    size_t low = stats.usable / RECLAIM_LOW_DIVISOR;
+    mutex_lock(&mutex_shrinkers);
+    watermark_low = low > RECLAIM_LOW_MIN ? low : RECLAIM_LOW_MIN;
+    watermark_high = watermark_low * RECLAIM_HIGH_FACTOR;
+    mutex_unlock(&mutex_shrinkers);
+    shrinker_register(&zero_pool_shrinker);
+    shrinker_register(&slab_shrinker);
+}
+
+void shrinker_register(shrinker_t *shrinker)
+{
+    mutex_lock(&mutex_shrinkers);
+    shrinker_t **link = &shrinkers;
+    while (*link != NULL) {
+        link = &(*link)->next;
+    }
+    shrinker->next = NULL;
+    *link = shrinker;
+    mutex_unlock(&mutex_shrinkers);
+}
+
+void shrinker_unregister(shrinker_t *shrinker)
+{
+    mutex_lock(&mutex_shrinkers);
+    for (shrinker_t **link = &shrinkers; *link != NULL; link = &(*link)->next) {
+        if (*link == shrinker) {
+            *link = shrinker->next;
+            break;
+        }
+    }
+    mutex_unlock(&mutex_shrinkers);
+}
+
+// Called with the shrinker lock held
+static size_t reclaim_scan(size_t pages)
+{
+    size_t freed = 0;
+    for (shrinker_t *shrinker = shrinkers; shrinker != NULL && freed < pages; shrinker = shrinker->next) {
+        if (shrinker->count != NULL && shrinker->count() == 0) {
+            continue;
+        }
+        freed += shrinker->scan(pages - freed);
+    }
+    reclaim_runs++;
+    reclaimed += freed;
+    return freed;
+}
+
+size_t reclaim_pages(size_t pages)
+{
+    // Whoever is reclaiming already frees memory for everybody
+    if (mutex_trylock(&mutex_shrinkers) != 0) {
+        return 0;
+    }
+    size_t freed = reclaim_scan(pages);
+    mutex_unlock(&mutex_shrinkers);
+    return freed;
+}
+
+void reclaim_task(void)
+{
+    while (true) {
+        size_t free = frames_free_count();
+        mutex_lock(&mutex_shrinkers);
+        if (free < watermark_low) {
+            reclaim_scan(watermark_high - free);
+        }
+        mutex_unlock(&mutex_shrinkers);
+        tasks_nano_sleep(RECLAIM_INTERVAL_MS * 1000ULL * 1000);
+    }
+}
+
+void reclaim_get_stats(reclaim_stats_t *stats)
+{
+    mutex_lock(&mutex_shrinkers);
+    stats->low = watermark_low;
+    stats->high = watermark_high;
+    stats->runs = reclaim_runs;
+    stats->reclaimed = reclaimed;
+    mutex_unlock(&mutex_shrinkers);
+}
+
+void reclaim_print_stats()
+{
+    reclaim_stats_t stats;
+    reclaim_get_stats(&stats);
+    rs232::printf("reclaim: watermarks %u/%u frames, %u pages reclaimed in %u passes\n",
+        stats.low, stats.high, stats.reclaimed, stats.runs);
+}
@@ -0,0 +1,93 @@
+/**
+ * @file reclaim.hpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Gives memory held by caches back when free frames run low
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The low watermark is a share of usable memory, with a floor for small
+// machines. Reclaim starts below it and stops once free frames are back
+// above the high watermark.
+#define RECLAIM_LOW_DIVISOR     64
+#define RECLAIM_LOW_MIN         64
+#define RECLAIM_HIGH_FACTOR     2
+// How often the reclaim task looks at the free frame count
+#define RECLAIM_INTERVAL_MS     50
+
+typedef struct shrinker {
+    const char *name;
+    // Pages that could be given back right now, only used as a hint
+    size_t (*count)(void);
+    // Gives back up to the given number of pages and returns how many it
+    // did. Called on the allocation path, so it must skip anything that
+    // is locked instead of waiting for it.
+    size_t (*scan)(size_t pages);
+    struct shrinker *next;
+} shrinker_t;
+
+typedef struct reclaim_stats {
+    size_t low;             // Free frames below which reclaim starts
+    size_t high;            // Free frames reclaim stops at
+    size_t runs;            // Passes over the shrinkers
+    size_t reclaimed;       // Pages given back by all passes
+} reclaim_stats_t;
+
+/**
+ * @brief Sets the watermarks from the amount of usable memory and registers
+ * the kernel's own caches. Called once the frame allocator is up.
+ *
+ */
+void reclaim_init();
+
+/**
+ * @brief Adds a cache that can give memory back. Shrinkers are asked in the
+ * order they were registered in.
+ *
+ * @param shrinker Shrinker that stays registered until unregistered
+ */
+void shrinker_register(shrinker_t *shrinker);
+
+/**
+ * @brief Removes a shrinker.
+ *
+ * @param shrinker Previously registered shrinker
+ */
+void shrinker_unregister(shrinker_t *shrinker);
+
+/**
+ * @brief Asks the shrinkers for pages right away. Used by allocations that
+ * ran out of frames. Returns without reclaiming anything if a reclaim pass
+ * is already running.
+ *
+ * @param pages Pages wanted
+ * @return size_t Pages given back
+ */
+size_t reclaim_pages(size_t pages);
+
+/**
+ * @brief Reclaim task. Keeps the free frame count between the watermarks so
+ * that allocations rarely have to reclaim on their own.
+ *
+ */
+void reclaim_task(void);
+
+/**
+ * @brief Fills in the watermarks and how much has been reclaimed.
+ *
+ * @param stats Statistics to be filled in
+ */
+void reclaim_get_stats(reclaim_stats_t *stats);
+
+/**
+ * @brief Prints the reclaim statistics over serial.
+ *
+ */
+void reclaim_print_stats();
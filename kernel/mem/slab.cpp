@@ -0,0 +1,283 @@
+/**
+ * @file slab.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Slab allocator for fixed-size kernel objects
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <mem/slab.hpp>
+#include <mem/paging.hpp>
+#include <mem/frames.hpp>
+#include <sys/panic.hpp>
+#include <dev/serial/rs232.hpp>
+
+// Marks the end of a slab's free list
+#define KMEM_BUFCTL_END 0xFFFF
+#define KMEM_ALIGN_UP(val, align) (((val) + (align) - 1) & ~((align) - 1))
+
+// Free objects are chained by index through an array following the slab
+// header so that constructed objects are never written to while free.
+typedef uint16_t kmem_bufctl_t;
+
+struct kmem_slab {
+    kmem_slab_t *prev;
+    kmem_slab_t *next;
+    kmem_cache_t *cache;
+    uint8_t *objects;       // First object, after colouring
+    size_t inuse;           // Objects handed out from this slab
+    kmem_bufctl_t free;     // Index of the first free object
+};
+
+// Caches are allocated from a cache of their own
+static kmem_cache_t cache_cache;
+static kmem_cache_t *caches = NULL;
+static mutex_t mutex_caches("kmem_caches");
+
+// Function prototypes
+static bool kmem_cache_setup(kmem_cache_t *cache, const char *name, size_t size, size_t align, kmem_ctor_t ctor);
+static void kmem_list_push(kmem_slab_t **list, kmem_slab_t *slab);
+static void kmem_list_remove(kmem_slab_t **list, kmem_slab_t *slab);
+static kmem_slab_t *kmem_slab_create(kmem_cache_t *cache);
+static void kmem_slab_destroy(kmem_cache_t *cache, kmem_slab_t *slab);
+static inline kmem_bufctl_t *kmem_slab_bufctl(kmem_slab_t *slab);
+
+static inline kmem_bufctl_t *kmem_slab_bufctl(kmem_slab_t *slab)
+{
+    return (kmem_bufctl_t *)(slab + 1);
+}
+
+static bool kmem_cache_setup(kmem_cache_t *cache, const char *name, size_t size, size_t align, kmem_ctor_t ctor)
+{
+    if (align == 0) {
+        align = sizeof(void *);
+    }
+    if (size == 0 || size > KMEM_MAX_OBJECT || (align & (align - 1)) || align > KMEM_CACHE_LINE) {
+        return false;
+    }
+    size = KMEM_ALIGN_UP(size, align);
+    // Fit as many objects as possible behind the header and free list
+    size_t count = (PAGE_SIZE - sizeof(kmem_slab_t)) / (size + sizeof(kmem_bufctl_t));
+    size_t offset = KMEM_ALIGN_UP(sizeof(kmem_slab_t) + count * sizeof(kmem_bufctl_t), align);
+    while (offset + count * size > PAGE_SIZE) {
+        count--;
+        offset = KMEM_ALIGN_UP(sizeof(kmem_slab_t) + count * sizeof(kmem_bufctl_t), align);
+    }
+    cache->name = name;
+    cache->size = size;
+    cache->align = align;
+    cache->offset = offset;
+    cache->per_slab = count;
+    // Whatever is left over at the end of a slab is used for colouring
+    cache->colours = (PAGE_SIZE - offset - count * size) / KMEM_CACHE_LINE + 1;
+    cache->colour_next = 0;
+    cache->ctor = ctor;
+    cache->partial = NULL;
+    cache->full = NULL;
+    cache->empty = NULL;
+    cache->stats = { /* Zero */ };
+    cache->next = NULL;
+    mutex_init(&cache->lock);
+    cache->lock.task_sync.dbg_name = name;
+    return true;
+}
+
+static void kmem_list_push(kmem_slab_t **list, kmem_slab_t *slab)
+{
+    slab->prev = NULL;
+    slab->next = *list;
+    if (*list) {
+        (*list)->prev = slab;
+    }
+    *list = slab;
+}
+
+static void kmem_list_remove(kmem_slab_t **list, kmem_slab_t *slab)
+{
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        *list = slab->next;
+    }
+    if (slab->next) {
+        slab->next->prev = slab->prev;
+    }
+    slab->prev = NULL;
+    slab->next = NULL;
+}
+
+static kmem_slab_t *kmem_slab_create(kmem_cache_t *cache)
+{
+    uint8_t *page = (uint8_t *)get_new_page(PAGE_SIZE - 1);
+    if (page == NULL) {
+        return NULL;
+    }
+    frame_set_flags(page_frame(page), FRAME_SLAB);
+    kmem_slab_t *slab = (kmem_slab_t *)page;
+    slab->prev = NULL;
+    slab->next = NULL;
+    slab->cache = cache;
+    slab->objects = page + cache->offset + cache->colour_next * KMEM_CACHE_LINE;
+    slab->inuse = 0;
+    slab->free = 0;
+    cache->colour_next = (cache->colour_next + 1) % cache->colours;
+    // Chain every object into the free list and construct it
+    kmem_bufctl_t *bufctl = kmem_slab_bufctl(slab);
+    for (size_t i = 0; i < cache->per_slab; i++) {
+        bufctl[i] = (i + 1 < cache->per_slab) ? (kmem_bufctl_t)(i + 1) : KMEM_BUFCTL_END;
+        if (cache->ctor) {
+            cache->ctor(slab->objects + i * cache->size);
+        }
+    }
+    cache->stats.slabs++;
+    cache->stats.total += cache->per_slab;
+    return slab;
+}
+
+static void kmem_slab_destroy(kmem_cache_t *cache, kmem_slab_t *slab)
+{
+    cache->stats.slabs--;
+    cache->stats.total -= cache->per_slab;
+    free_page(slab, PAGE_SIZE - 1);
+}
+
+kmem_cache_t *kmem_cache_create(const char *name, size_t size, size_t align, kmem_ctor_t ctor)
+{
+    mutex_lock(&mutex_caches);
+    if (cache_cache.size == 0) {
+        kmem_cache_setup(&cache_cache, "kmem_cache", sizeof(kmem_cache_t), 0, NULL);
+        caches = &cache_cache;
+    }
+    kmem_cache_t *cache = (kmem_cache_t *)kmem_cache_alloc(&cache_cache);
+    if (cache != NULL) {
+        if (kmem_cache_setup(cache, name, size, align, ctor)) {
+            cache->next = caches;
+            caches = cache;
+        } else {
+            kmem_cache_free(&cache_cache, cache);
+            cache = NULL;
+        }
+    }
+    mutex_unlock(&mutex_caches);
+    return cache;
+}
+
+void *kmem_cache_alloc(kmem_cache_t *cache)
+{
+    mutex_lock(&cache->lock);
+    kmem_slab_t *slab = cache->partial;
+    if (slab == NULL) {
+        // Reuse an empty slab before asking for a new page
+        slab = cache->empty;
+        if (slab != NULL) {
+            kmem_list_remove(&cache->empty, slab);
+        } else if ((slab = kmem_slab_create(cache)) == NULL) {
+            mutex_unlock(&cache->lock);
+            return NULL;
+        }
+        kmem_list_push(&cache->partial, slab);
+    }
+    size_t idx = slab->free;
+    slab->free = kmem_slab_bufctl(slab)[idx];
+    if (++slab->inuse == cache->per_slab) {
+        kmem_list_remove(&cache->partial, slab);
+        kmem_list_push(&cache->full, slab);
+    }
+    cache->stats.allocs++;
+    cache->stats.active++;
+    mutex_unlock(&cache->lock);
+    return slab->objects + idx * cache->size;
+}
+
+void kmem_cache_free(kmem_cache_t *cache, void *obj)
+{
+    if (obj == NULL) {
+        return;
+    }
+    // Slabs are single pages with the header at the start
+    kmem_slab_t *slab = (kmem_slab_t *)((uintptr_t)obj & ~((uintptr_t)PAGE_SIZE - 1));
+    if (slab->cache != cache) {
+        PANIC("Attempted to free an object to the wrong slab cache.\n");
+    }
+    size_t idx = ((uintptr_t)obj - (uintptr_t)slab->objects) / cache->size;
+    if ((uint8_t *)obj < slab->objects || idx >= cache->per_slab || slab->objects + idx * cache->size != obj) {
+        PANIC("Attempted to free an invalid slab object.\n");
+    }
+    mutex_lock(&cache->lock);
+    if (slab->inuse == 0) {
+        PANIC("Attempted to free a slab object twice.\n");
+    }
+#ifdef DEBUG
+    // A slab with other live objects only notices by walking its free chain
+    for (size_t free = slab->free; free != KMEM_BUFCTL_END; free = kmem_slab_bufctl(slab)[free]) {
+        if (free == idx) {
+            PANIC("Attempted to free a slab object twice.\n");
+        }
+    }
+#endif
+    kmem_slab_bufctl(slab)[idx] = slab->free;
+    slab->free = (kmem_bufctl_t)idx;
+    if (slab->inuse-- == cache->per_slab) {
+        kmem_list_remove(&cache->full, slab);
+        kmem_list_push(&cache->partial, slab);
+    }
+    if (slab->inuse == 0) {
+        // Keep a single empty slab around to avoid thrashing pages
+        kmem_list_remove(&cache->partial, slab);
+        if (cache->empty == NULL) {
+            kmem_list_push(&cache->empty, slab);
+        } else {
+            kmem_slab_destroy(cache, slab);
+        }
+    }
+    cache->stats.frees++;
+    cache->stats.active--;
+    mutex_unlock(&cache->lock);
+}
+
+void kmem_cache_print_stats()
+{
+    mutex_lock(&mutex_caches);
+    rs232::printf("%-16s %6s %6s %6s %6s %10s %10s\n",
+        "cache", "size", "active", "total", "slabs", "allocs", "frees");
+    for (kmem_cache_t *cache = caches; cache != NULL; cache = cache->next) {
+        rs232::printf("%-16s %6u %6u %6u %6u %10u %10u\n",
+            cache->name, cache->size, cache->stats.active, cache->stats.total,
+            cache->stats.slabs, cache->stats.allocs, cache->stats.frees);
+    }
+    mutex_unlock(&mutex_caches);
+}
+
+size_t kmem_cache_reclaimable()
+{
+    size_t pages = 0;
+    for (kmem_cache_t *cache = caches; cache != NULL; cache = cache->next) {
+        pages += cache->empty != NULL;
+    }
+    return pages;
+}
+
+size_t kmem_cache_reap(size_t pages)
+{
+    // Reclaim runs on behalf of allocations that may hold any of these
+    if (mutex_trylock(&mutex_caches) != 0) {
+        return 0;
+    }
+    size_t reaped = 0;
+    for (kmem_cache_t *cache = caches; cache != NULL && reaped < pages; cache = cache->next) {
+        if (cache->empty == NULL || mutex_trylock(&cache->lock) != 0) {
+            continue;
+        }
+        while (cache->empty != NULL && reaped < pages) {
+            kmem_slab_t *slab = cache->empty;
+            kmem_list_remove(&cache->empty, slab);
+            kmem_slab_destroy(cache, slab);
+            reaped++;
+        }
+        mutex_unlock(&cache->lock);
+    }
+    mutex_unlock(&mutex_caches);
+    return reaped;
+}
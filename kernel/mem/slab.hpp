@@ -0,0 +1,105 @@
+/**
+ * @file slab.hpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Slab allocator for fixed-size kernel objects
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <lib/mutex.hpp>
+
+// Slabs are coloured in steps of one cache line
+#define KMEM_CACHE_LINE     64
+// Every slab is a single page, so objects are kept reasonably small
+#define KMEM_MAX_OBJECT     512
+
+typedef void (*kmem_ctor_t)(void *obj);
+typedef struct kmem_slab kmem_slab_t;
+
+typedef struct kmem_cache_stats {
+    size_t allocs;      // Objects handed out over the life of the cache
+    size_t frees;       // Objects given back over the life of the cache
+    size_t active;      // Objects currently in use
+    size_t total;       // Objects held by all slabs
+    size_t slabs;       // Slabs (pages) owned by the cache
+} kmem_cache_stats_t;
+
+typedef struct kmem_cache {
+    const char *name;
+    size_t size;            // Object size rounded up to the alignment
+    size_t align;           // Object alignment
+    size_t offset;          // Offset of the first object in an uncoloured slab
+    size_t per_slab;        // Objects held by every slab
+    size_t colours;         // Number of distinct colours slabs rotate through
+    size_t colour_next;     // Colour given to the next slab
+    kmem_ctor_t ctor;       // Optional constructor run when a slab is created
+    kmem_slab_t *partial;   // Slabs with both used and free objects
+    kmem_slab_t *full;      // Slabs without free objects
+    kmem_slab_t *empty;     // Slabs without used objects
+    kmem_cache_stats_t stats;
+    mutex_t lock;
+    struct kmem_cache *next;
+} kmem_cache_t;
+
+/**
+ * @brief Creates a cache of objects of a given size. Objects are carved out
+ * of page sized slabs which are staggered by a cache line (coloured) so that
+ * objects of different slabs do not compete for the same cache sets.
+ *
+ * If a constructor is given, it is run once for every object when its slab is
+ * created rather than on every allocation. Objects must be returned to the
+ * cache in their constructed state.
+ *
+ * @param name Name of the cache used for statistics
+ * @param size Object size in bytes (at most KMEM_MAX_OBJECT)
+ * @param align Object alignment (a power of two up to KMEM_CACHE_LINE, 0 for pointer alignment)
+ * @param ctor Optional object constructor
+ * @return kmem_cache_t* New cache or NULL on failure
+ */
+kmem_cache_t *kmem_cache_create(const char *name, size_t size, size_t align, kmem_ctor_t ctor);
+
+/**
+ * @brief Allocates an object from a cache.
+ *
+ * @param cache Cache to allocate from
+ * @return void* Object or NULL if out of memory
+ */
+void *kmem_cache_alloc(kmem_cache_t *cache);
+
+/**
+ * @brief Returns an object to the cache it was allocated from.
+ *
+ * @param cache Cache the object belongs to
+ * @param obj Object to be freed
+ */
+void kmem_cache_free(kmem_cache_t *cache, void *obj);
+
+/**
+ * @brief Prints the statistics of every cache over serial.
+ *
+ */
+void kmem_cache_print_stats();
+
+/**
+ * @brief Counts the empty slabs kept around by all caches. Unlocked, so
+ * the result is only a hint.
+ *
+ * @return size_t Pages that kmem_cache_reap() could give back
+ */
+size_t kmem_cache_reclaimable();
+
+/**
+ * @brief Gives the empty slabs of all caches back to the paging code. Caches
+ * that are busy are skipped instead of waited for, so this is safe to call
+ * while allocating.
+ *
+ * @param pages Most pages to give back
+ * @return size_t Pages given back
+ */
+size_t kmem_cache_reap(size_t pages);
@@ -0,0 +1,405 @@
+/**
+ * @file tlsf.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Two-level segregated fit (TLSF) memory allocator
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ * Based on the design described by M. Masmano, I. Ripoll, A. Crespo and
+ * J. Real in "TLSF: a New Dynamic Memory Allocator for Real-Time Systems".
+ */
+#include <mem/tlsf.hpp>
+#include <sys/panic.hpp>
+
+// The low bits of the size are free because sizes are aligned
+#define BLOCK_FREE_BIT      ((size_t)1)
+#define BLOCK_PREV_FREE_BIT ((size_t)2)
+#define BLOCK_FLAGS         (BLOCK_FREE_BIT | BLOCK_PREV_FREE_BIT)
+// Only the size field is overhead for a used block
+#define BLOCK_OVERHEAD      (sizeof(size_t))
+#define BLOCK_START_OFFSET  (offsetof(tlsf_block_t, size) + sizeof(size_t))
+// A free block must be able to hold its free list links
+#define BLOCK_SIZE_MIN      (sizeof(tlsf_block_t) - sizeof(tlsf_block_t *))
+#define BLOCK_SIZE_MAX      ((size_t)1 << TLSF_FL_INDEX_MAX)
+
+// Function prototypes
+static inline size_t block_size(tlsf_block_t *block);
+static inline bool block_is_free(tlsf_block_t *block);
+static inline bool block_is_prev_free(tlsf_block_t *block);
+static inline void block_set_prev_free(tlsf_block_t *block, bool free);
+static inline tlsf_block_t *block_from_ptr(void *ptr);
+static inline void *block_to_ptr(tlsf_block_t *block);
+static inline tlsf_block_t *block_next(tlsf_block_t *block);
+static inline tlsf_block_t *block_link_next(tlsf_block_t *block);
+static inline void block_mark_as_free(tlsf_block_t *block);
+static inline void block_mark_as_used(tlsf_block_t *block);
+static inline tlsf_block_t *block_absorb(tlsf_block_t *prev, tlsf_block_t *block);
+static inline bool block_can_split(tlsf_block_t *block, size_t size);
+static tlsf_block_t *block_split(tlsf_block_t *block, size_t size);
+static inline size_t tlsf_fls(size_t word);
+static void mapping_insert(size_t size, size_t *fl, size_t *sl);
+static void mapping_search(size_t size, size_t *fl, size_t *sl);
+static size_t adjust_request_size(size_t size);
+
+static inline size_t block_size(tlsf_block_t *block)
+{
+    return block->size & ~BLOCK_FLAGS;
+}
+
+static inline bool block_is_free(tlsf_block_t *block)
+{
+    return block->size & BLOCK_FREE_BIT;
+}
+
+static inline bool block_is_prev_free(tlsf_block_t *block)
+{
+    return block->size & BLOCK_PREV_FREE_BIT;
+}
+
+static inline void block_set_prev_free(tlsf_block_t *block, bool free)
+{
+    block->size = free ? (block->size | BLOCK_PREV_FREE_BIT) : (block->size & ~BLOCK_PREV_FREE_BIT);
+}
+
+static inline tlsf_block_t *block_from_ptr(void *ptr)
+{
+    return (tlsf_block_t *)((uint8_t *)ptr - BLOCK_START_OFFSET);
+}
+
+static inline void *block_to_ptr(tlsf_block_t *block)
+{
+    return (uint8_t *)block + BLOCK_START_OFFSET;
+}
+
+static inline tlsf_block_t *block_next(tlsf_block_t *block)
+{
+    // The next header starts in the last word of this block
+    return (tlsf_block_t *)((uint8_t *)block_to_ptr(block) + block_size(block) - BLOCK_OVERHEAD);
+}
+
+static inline tlsf_block_t *block_link_next(tlsf_block_t *block)
+{
+    tlsf_block_t *next = block_next(block);
+    next->prev_phys = block;
+    return next;
+}
+
+static inline void block_mark_as_free(tlsf_block_t *block)
+{
+    tlsf_block_t *next = block_link_next(block);
+    block_set_prev_free(next, true);
+    block->size |= BLOCK_FREE_BIT;
+}
+
+static inline void block_mark_as_used(tlsf_block_t *block)
+{
+    tlsf_block_t *next = block_next(block);
+    block_set_prev_free(next, false);
+    block->size &= ~BLOCK_FREE_BIT;
+}
+
+static inline tlsf_block_t *block_absorb(tlsf_block_t *prev, tlsf_block_t *block)
+{
+    // The header of the absorbed block becomes part of the data
+    prev->size += block_size(block) + BLOCK_OVERHEAD;
+    block_link_next(prev);
+    return prev;
+}
+
+static inline bool block_can_split(tlsf_block_t *block, size_t size)
+{
+    return block_size(block) >= sizeof(tlsf_block_t) + size;
+}
+
+static tlsf_block_t *block_split(tlsf_block_t *block, size_t size)
+{
+    tlsf_block_t *remaining = (tlsf_block_t *)((uint8_t *)block_to_ptr(block) + size - BLOCK_OVERHEAD);
+    remaining->size = block_size(block) - (size + BLOCK_OVERHEAD);
+    block->size = size | (block->size & BLOCK_FLAGS);
+    block_mark_as_free(remaining);
+    return remaining;
+}
+
+static inline size_t tlsf_fls(size_t word)
+{
+    return sizeof(size_t) * 8 - 1 - __builtin_clzl(word);
+}
+
+static void mapping_insert(size_t size, size_t *fl, size_t *sl)
+{
+    if (size < TLSF_SMALL_BLOCK_SIZE) {
+        // Small blocks are spread linearly over the first list
+        *fl = 0;
+        *sl = size / (TLSF_SMALL_BLOCK_SIZE / TLSF_SL_INDEX_COUNT);
+    } else {
+        size_t bit = tlsf_fls(size);
+        *sl = (size >> (bit - TLSF_SL_INDEX_LOG2)) ^ (1 << TLSF_SL_INDEX_LOG2);
+        *fl = bit - (TLSF_FL_INDEX_SHIFT - 1);
+    }
+}
+
+static void mapping_search(size_t size, size_t *fl, size_t *sl)
+{
+    // Round up to the next list so that any block found is big enough
+    if (size >= TLSF_SMALL_BLOCK_SIZE) {
+        size += ((size_t)1 << (tlsf_fls(size) - TLSF_SL_INDEX_LOG2)) - 1;
+    }
+    mapping_insert(size, fl, sl);
+}
+
+static size_t adjust_request_size(size_t size)
+{
+    if (size == 0 || size >= BLOCK_SIZE_MAX) {
+        return 0;
+    }
+    size = (size + TLSF_ALIGN_SIZE - 1) & ~((size_t)TLSF_ALIGN_SIZE - 1);
+    return size < BLOCK_SIZE_MIN ? BLOCK_SIZE_MIN : size;
+}
+
+size_t TlsfHeap::PoolOverhead()
+{
+    // The first block's size and the sentinel block's size
+    return 2 * BLOCK_OVERHEAD;
+}
+
+TlsfHeap::TlsfHeap()
+    : flBitmap(0)
+    , poolSize(0)
+    , freeSize(0)
+    , freeBlocks(0)
+{
+    for (size_t fl = 0; fl < TLSF_FL_INDEX_COUNT; fl++) {
+        slBitmap[fl] = 0;
+        for (size_t sl = 0; sl < TLSF_SL_INDEX_COUNT; sl++) {
+            blocks[fl][sl] = NULL;
+        }
+    }
+}
+
+void TlsfHeap::InsertFree(tlsf_block_t *block)
+{
+    size_t fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    tlsf_block_t *head = blocks[fl][sl];
+    block->next_free = head;
+    block->prev_free = NULL;
+    if (head) {
+        head->prev_free = block;
+    }
+    blocks[fl][sl] = block;
+    flBitmap |= (uint32_t)1 << fl;
+    slBitmap[fl] |= (uint32_t)1 << sl;
+    freeSize += block_size(block);
+    freeBlocks++;
+}
+
+void TlsfHeap::RemoveFree(tlsf_block_t *block)
+{
+    size_t fl, sl;
+    mapping_insert(block_size(block), &fl, &sl);
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        blocks[fl][sl] = block->next_free;
+        // Clear the bitmaps once the list runs dry
+        if (blocks[fl][sl] == NULL) {
+            slBitmap[fl] &= ~((uint32_t)1 << sl);
+            if (slBitmap[fl] == 0) {
+                flBitmap &= ~((uint32_t)1 << fl);
+            }
+        }
+    }
+    if (block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    }
+    freeSize -= block_size(block);
+    freeBlocks--;
+}
+
+tlsf_block_t *TlsfHeap::MergePrev(tlsf_block_t *block)
+{
+    if (block_is_prev_free(block)) {
+        tlsf_block_t *prev = block->prev_phys;
+        RemoveFree(prev);
+        block = block_absorb(prev, block);
+    }
+    return block;
+}
+
+tlsf_block_t *TlsfHeap::MergeNext(tlsf_block_t *block)
+{
+    tlsf_block_t *next = block_next(block);
+    if (block_is_free(next)) {
+        RemoveFree(next);
+        block = block_absorb(block, next);
+    }
+    return block;
+}
+
+void TlsfHeap::TrimFree(tlsf_block_t *block, size_t size)
+{
+    // Hand the tail of a block that is about to be used back
+    if (block_can_split(block, size)) {
+        tlsf_block_t *remaining = block_split(block, size);
+        block_link_next(block);
+        block_set_prev_free(remaining, true);
+        InsertFree(remaining);
+    }
+}
+
+void TlsfHeap::TrimUsed(tlsf_block_t *block, size_t size)
+{
+    // Hand the tail of a used block back, merging it with what follows
+    if (block_can_split(block, size)) {
+        tlsf_block_t *remaining = block_split(block, size);
+        block_set_prev_free(remaining, false);
+        remaining = MergeNext(remaining);
+        InsertFree(remaining);
+    }
+}
+
+tlsf_block_t *TlsfHeap::LocateFree(size_t size)
+{
+    size_t fl, sl;
+    mapping_search(size, &fl, &sl);
+    if (fl >= TLSF_FL_INDEX_COUNT) {
+        return NULL;
+    }
+    // Look in the same first level list for a big enough second level
+    // list and move up to the next non-empty first level list otherwise
+    uint32_t sl_map = slBitmap[fl] & (~(uint32_t)0 << sl);
+    if (sl_map == 0) {
+        uint32_t fl_map = (fl + 1 < 32) ? flBitmap & (~(uint32_t)0 << (fl + 1)) : 0;
+        if (fl_map == 0) {
+            return NULL;
+        }
+        fl = __builtin_ctz(fl_map);
+        sl_map = slBitmap[fl];
+    }
+    sl = __builtin_ctz(sl_map);
+    tlsf_block_t *block = blocks[fl][sl];
+    RemoveFree(block);
+    return block;
+}
+
+bool TlsfHeap::AddPool(void *mem, size_t size)
+{
+    if ((uintptr_t)mem % TLSF_ALIGN_SIZE || size <= PoolOverhead()) {
+        return false;
+    }
+    size_t pool_bytes = (size - PoolOverhead()) & ~((size_t)TLSF_ALIGN_SIZE - 1);
+    if (pool_bytes < BLOCK_SIZE_MIN || pool_bytes >= BLOCK_SIZE_MAX) {
+        return false;
+    }
+    // The first block's previous block pointer sits just in front of the
+    // pool, but it is never used since there is no block before it
+    tlsf_block_t *block = (tlsf_block_t *)((uint8_t *)mem - BLOCK_OVERHEAD);
+    block->size = pool_bytes | BLOCK_FREE_BIT;
+    InsertFree(block);
+    // A zero sized used block marks the end of the pool
+    tlsf_block_t *sentinel = block_link_next(block);
+    sentinel->size = BLOCK_PREV_FREE_BIT;
+    poolSize += size;
+    return true;
+}
+
+void *TlsfHeap::Alloc(size_t size)
+{
+    size_t adjust = adjust_request_size(size);
+    if (adjust == 0) {
+        return NULL;
+    }
+    tlsf_block_t *block = LocateFree(adjust);
+    if (block == NULL) {
+        return NULL;
+    }
+    TrimFree(block, adjust);
+    block_mark_as_used(block);
+    return block_to_ptr(block);
+}
+
+void TlsfHeap::Free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    tlsf_block_t *block = block_from_ptr(ptr);
+    if (block_is_free(block)) {
+        PANIC("Attempted to free a heap block twice.\n");
+    }
+    block_mark_as_free(block);
+    block = MergePrev(block);
+    block = MergeNext(block);
+    InsertFree(block);
+}
+
+void *TlsfHeap::Realloc(void *ptr, size_t size)
+{
+    if (ptr == NULL) {
+        return Alloc(size);
+    }
+    if (size == 0) {
+        Free(ptr);
+        return NULL;
+    }
+    if (Resize(ptr, size)) {
+        return ptr;
+    }
+    if (adjust_request_size(size) == 0) {
+        return NULL;
+    }
+    // No room to grow in place, so move the data
+    size_t current = block_size(block_from_ptr(ptr));
+    void *moved = Alloc(size);
+    if (moved != NULL) {
+        size_t words = ((current < size ? current : size) + sizeof(size_t) - 1) / sizeof(size_t);
+        size_t *dst = (size_t *)moved;
+        size_t *src = (size_t *)ptr;
+        for (size_t i = 0; i < words; i++) {
+            dst[i] = src[i];
+        }
+        Free(ptr);
+    }
+    return moved;
+}
+
+bool TlsfHeap::Resize(void *ptr, size_t size)
+{
+    tlsf_block_t *block = block_from_ptr(ptr);
+    tlsf_block_t *next = block_next(block);
+    size_t current = block_size(block);
+    size_t combined = current + block_size(next) + BLOCK_OVERHEAD;
+    size_t adjust = adjust_request_size(size);
+    if (adjust == 0 || (adjust > current && (!block_is_free(next) || adjust > combined))) {
+        return false;
+    }
+    if (adjust > current) {
+        MergeNext(block);
+        block_mark_as_used(block);
+    }
+    TrimUsed(block, adjust);
+    return true;
+}
+
+size_t TlsfHeap::BlockSize(void *ptr)
+{
+    return ptr ? block_size(block_from_ptr(ptr)) : 0;
+}
+
+size_t TlsfHeap::LargestFree()
+{
+    if (flBitmap == 0) {
+        return 0;
+    }
+    size_t fl = tlsf_fls(flBitmap);
+    size_t sl = tlsf_fls(slBitmap[fl]);
+    size_t largest = 0;
+    for (tlsf_block_t *block = blocks[fl][sl]; block != NULL; block = block->next_free) {
+        if (block_size(block) > largest) {
+            largest = block_size(block);
+        }
+    }
+    return largest;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file tlsf.hpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Two-level segregated fit (TLSF) memory allocator
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <meta/compiler.hpp>
+
+// Every allocation is aligned to (and a multiple of) the size of a pointer
+#define TLSF_ALIGN_SIZE_LOG2    (sizeof(size_t) == 8 ? 3 : 2)
+#define TLSF_ALIGN_SIZE         (1 << TLSF_ALIGN_SIZE_LOG2)
+// Each power of two size range is split into 32 lists
+#define TLSF_SL_INDEX_LOG2      5
+#define TLSF_SL_INDEX_COUNT     (1 << TLSF_SL_INDEX_LOG2)
+// Blocks smaller than this all share the first level
+#define TLSF_FL_INDEX_SHIFT     (TLSF_SL_INDEX_LOG2 + TLSF_ALIGN_SIZE_LOG2)
+#define TLSF_SMALL_BLOCK_SIZE   (1 << TLSF_FL_INDEX_SHIFT)
+// Largest block is 1 GiB on 32-bit targets
+#define TLSF_FL_INDEX_MAX       (sizeof(size_t) == 8 ? 32 : 30)
+#define TLSF_FL_INDEX_COUNT     (TLSF_FL_INDEX_MAX - TLSF_FL_INDEX_SHIFT + 1)
+
+/**
+ * @brief Header of a block of heap memory. The previous block pointer
+ * lives in the last word of the previous block and is only valid while
+ * that block is free. The free list links are only valid while this block
+ * is free and overlap the start of the user data otherwise.
+ */
+typedef struct tlsf_block {
+    struct tlsf_block *prev_phys;
+    size_t size;
+    struct tlsf_block *next_free;
+    struct tlsf_block *prev_free;
+} tlsf_block_t;
+
+/**
+ * @brief A two-level segregated fit allocator. Free blocks are binned by
+ * their size class: the first level is the power of two, the second level
+ * splits that range linearly. A pair of bitmaps records which bins are
+ * non-empty, so finding a block and freeing one (with coalescing of both
+ * physical neighbours) take a constant number of steps regardless of heap
+ * size or history. Memory is handed to the allocator in pools.
+ */
+class TlsfHeap {
+public:
+    /**
+     * @brief Returns the number of bytes of a pool used for bookkeeping.
+     *
+     * @return size_t Overhead in bytes
+     */
+    static size_t PoolOverhead();
+
+    TlsfHeap();
+    /**
+     * @brief Hands a region of memory over to the allocator.
+     *
+     * @param mem Start of the region (aligned to TLSF_ALIGN_SIZE)
+     * @param size Size of the region in bytes
+     * @return true The region was added
+     * @return false The region was too small, too large or misaligned
+     */
+    bool AddPool(void *mem, size_t size);
+    /**
+     * @brief Allocates memory.
+     *
+     * @param size Number of bytes
+     * @return void* Memory or NULL if no block is large enough
+     */
+    void *Alloc(size_t size);
+    /**
+     * @brief Returns memory obtained from Alloc() or Realloc().
+     *
+     * @param ptr Memory to be freed (may be NULL)
+     */
+    void Free(void *ptr);
+    /**
+     * @brief Resizes an allocation, growing into the following block
+     * in place when possible.
+     *
+     * @param ptr Memory to be resized (may be NULL)
+     * @param size New size in bytes
+     * @return void* Resized memory or NULL if it could not be resized,
+     * in which case ptr is left untouched
+     */
+    void *Realloc(void *ptr, size_t size);
+    /**
+     * @brief Resizes an allocation without moving it, by growing into the
+     * following block or giving back its tail. Constant time.
+     *
+     * @param ptr Memory returned by Alloc() or Realloc()
+     * @param size New size in bytes (not 0)
+     * @return true The allocation now holds at least size bytes
+     * @return false There is no room behind it, ptr is left untouched
+     */
+    bool Resize(void *ptr, size_t size);
+    /**
+     * @brief Returns the usable size of an allocation.
+     *
+     * @param ptr Memory returned by Alloc()
+     * @return size_t Usable size in bytes
+     */
+    size_t BlockSize(void *ptr);
+    /**
+     * @brief Returns the size of the largest free block. Unlike the
+     * allocator itself this walks a free list and is meant for statistics.
+     *
+     * @return size_t Size in bytes
+     */
+    size_t LargestFree();
+    ALWAYS_INLINE size_t PoolSize() { return poolSize; }
+    ALWAYS_INLINE size_t FreeSize() { return freeSize; }
+    ALWAYS_INLINE size_t FreeBlocks() { return freeBlocks; }
+
+private:
+    uint32_t flBitmap;
+    uint32_t slBitmap[TLSF_FL_INDEX_COUNT];
+    tlsf_block_t *blocks[TLSF_FL_INDEX_COUNT][TLSF_SL_INDEX_COUNT];
+    size_t poolSize;
+    size_t freeSize;
+    size_t freeBlocks;
+
+    void InsertFree(tlsf_block_t *block);
+    void RemoveFree(tlsf_block_t *block);
+    tlsf_block_t *MergePrev(tlsf_block_t *block);
+    tlsf_block_t *MergeNext(tlsf_block_t *block);
+    void TrimFree(tlsf_block_t *block, size_t size);
+    void TrimUsed(tlsf_block_t *block, size_t size);
+    tlsf_block_t *LocateFree(size_t size);
+};
@@ -0,0 +1,265 @@
+/**
+ * @file tlsf_impl.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Kernel heap backed by the TLSF allocator
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#ifdef HEAP_TLSF
+
+#include <mem/heap.hpp>
+#include <mem/tlsf.hpp>
+#include <mem/paging.hpp>
+#include <mem/memstats.hpp>
+#include <lib/string.hpp>
+#include <dev/serial/rs232.hpp>
+
+// Smallest pool requested from the paging code at once
+#define HEAP_GROW_MIN (16 * PAGE_SIZE)
+// Allocations this big get pages of their own instead of being carved out
+// of a pool. Below LARGE_PAGE_SIZE they are backed on demand, from there on
+// they are backed by large pages. realloc() never copies them.
+#define HEAP_LARGE_MIN (16 * PAGE_SIZE)
+// Set in the word in front of a page backed allocation. A pool block keeps
+// its size there with the free bit clear while it is in use.
+#define HEAP_LARGE_BIT ((size_t)1)
+
+// Sits at the start of the pages of a large allocation, so that free() and
+// realloc() find its size without searching for it
+typedef struct heap_large {
+    size_t reserved[3];     // Keeps the memory handed out 16 byte aligned
+    size_t bytes;           // Bytes of address space, with HEAP_LARGE_BIT set
+} heap_large_t;
+
+// The heap is only touched with interrupts disabled, for a handful of
+// constant time steps. Anything that maps pages happens outside of it.
+static TlsfHeap heap;
+static size_t large_bytes = 0;
+
+// Function prototypes
+static inline size_t heap_irq_save();
+static inline void heap_irq_restore(size_t flags);
+static bool heap_grow(size_t size);
+static void *heap_alloc(size_t size, void *caller);
+static heap_large_t *heap_large_find(void *ptr);
+static void *heap_large_pages(size_t bytes);
+static void *heap_large_alloc(size_t size);
+static void *heap_large_realloc(heap_large_t *entry, size_t size);
+static void heap_large_free(heap_large_t *entry);
+
+static inline size_t heap_irq_save()
+{
+    size_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r"(flags) :: "memory");
+    return flags;
+}
+
+static inline void heap_irq_restore(size_t flags)
+{
+    asm volatile("push %0; popf" :: "r"(flags) : "memory", "cc");
+}
+
+static bool heap_grow(size_t size)
+{
+    // Growing the heap is the only part of an allocation that is not
+    // constant time, so ask for more than needed to keep it rare
+    size_t bytes = PAGE_ALIGN_UP(size + TlsfHeap::PoolOverhead() + sizeof(tlsf_block_t));
+    if (bytes < HEAP_GROW_MIN) {
+        bytes = HEAP_GROW_MIN;
+    }
+    // Only the pages that blocks are carved out of get backed by frames,
+    // except for big pools which are backed right away with large pages
+    void *pool = bytes >= LARGE_PAGE_SIZE ? get_new_page(bytes - 1) : get_demand_page(bytes - 1);
+    if (pool == NULL) {
+        return false;
+    }
+    size_t flags = heap_irq_save();
+    bool added = heap.AddPool(pool, bytes);
+    heap_irq_restore(flags);
+    if (!added) {
+        free_page(pool, bytes - 1);
+        return false;
+    }
+    mem_stats_add(MEM_OWNER_HEAP, bytes / PAGE_SIZE);
+    return true;
+}
+
+static heap_large_t *heap_large_find(void *ptr)
+{
+    // Only the word in front of the memory is looked at, pool blocks in
+    // use never have the bit set there
+    if (((uintptr_t)ptr & NOT_PAGE_ALIGN) != sizeof(heap_large_t)) {
+        return NULL;
+    }
+    heap_large_t *entry = (heap_large_t *)ptr - 1;
+    return (entry->bytes & HEAP_LARGE_BIT) ? entry : NULL;
+}
+
+static void *heap_large_pages(size_t bytes)
+{
+    // Same as the pools, big ones are backed right away with large pages
+    return bytes >= LARGE_PAGE_SIZE ? get_new_page(bytes - 1) : get_demand_page(bytes - 1);
+}
+
+static void *heap_large_alloc(size_t size)
+{
+    if (size > SIZE_MAX - PAGE_SIZE - sizeof(heap_large_t)) {
+        return NULL;
+    }
+    size_t bytes = PAGE_ALIGN_UP(size + sizeof(heap_large_t));
+    heap_large_t *entry = (heap_large_t *)heap_large_pages(bytes);
+    if (entry == NULL) {
+        return NULL;
+    }
+    entry->bytes = bytes | HEAP_LARGE_BIT;
+    __atomic_add_fetch(&large_bytes, bytes, __ATOMIC_RELAXED);
+    mem_stats_add(MEM_OWNER_HEAP, bytes / PAGE_SIZE);
+    return entry + 1;
+}
+
+static void *heap_large_realloc(heap_large_t *entry, size_t size)
+{
+    if (size > SIZE_MAX - PAGE_SIZE - sizeof(heap_large_t)) {
+        return NULL;
+    }
+    size_t old_bytes = entry->bytes & ~HEAP_LARGE_BIT;
+    size_t bytes = PAGE_ALIGN_UP(size + sizeof(heap_large_t));
+    // The paging code extends or moves the pages, the data stays put
+    heap_large_t *moved = (heap_large_t *)resize_page(entry, old_bytes - 1, bytes - 1);
+    if (moved == NULL) {
+        return NULL;
+    }
+    if (bytes > old_bytes) {
+        mem_stats_add(MEM_OWNER_HEAP, (bytes - old_bytes) / PAGE_SIZE);
+    } else {
+        mem_stats_sub(MEM_OWNER_HEAP, (old_bytes - bytes) / PAGE_SIZE);
+    }
+    __atomic_add_fetch(&large_bytes, bytes - old_bytes, __ATOMIC_RELAXED);
+    moved->bytes = bytes | HEAP_LARGE_BIT;
+    return moved + 1;
+}
+
+static void heap_large_free(heap_large_t *entry)
+{
+    size_t bytes = entry->bytes & ~HEAP_LARGE_BIT;
+    // A stale pointer to the pages must not pass for a large allocation
+    entry->bytes = 0;
+    free_page(entry, bytes - 1);
+    mem_stats_sub(MEM_OWNER_HEAP, bytes / PAGE_SIZE);
+    __atomic_sub_fetch(&large_bytes, bytes, __ATOMIC_RELAXED);
+}
+
+void heap_get_stats(heap_stats_t *stats)
+{
+    size_t flags = heap_irq_save();
+    stats->pool = heap.PoolSize() + large_bytes;
+    stats->free = heap.FreeSize();
+    stats->free_blocks = heap.FreeBlocks();
+    stats->largest_free = heap.LargestFree();
+    heap_irq_restore(flags);
+}
+
+void heap_print_stats()
+{
+    heap_stats_t stats;
+    heap_get_stats(&stats);
+    rs232::printf("heap: %u bytes in pools, %u free in %u blocks, largest %u\n",
+        stats.pool, stats.free, stats.free_blocks, stats.largest_free);
+}
+
+static void *heap_alloc(size_t size, void *caller)
+{
+    void *ptr = size >= HEAP_LARGE_MIN ? heap_large_alloc(size) : NULL;
+    if (ptr == NULL) {
+        size_t flags = heap_irq_save();
+        ptr = heap.Alloc(size);
+        heap_irq_restore(flags);
+    }
+    if (ptr == NULL && size != 0 && heap_grow(size)) {
+        size_t flags = heap_irq_save();
+        ptr = heap.Alloc(size);
+        heap_irq_restore(flags);
+    }
+    heap_profile_alloc(ptr, size, caller);
+    return ptr;
+}
+
+extern "C" {
+
+void *malloc(size_t size)
+{
+    return heap_alloc(size, __builtin_return_address(0));
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    if (ptr == NULL) {
+        return heap_alloc(size, __builtin_return_address(0));
+    }
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    heap_large_t *entry = heap_large_find(ptr);
+    void *res = NULL;
+    if (entry != NULL) {
+        // Recorded up front, the old pages may be handed out again as
+        // soon as they are moved away from
+        heap_profile_free(ptr);
+        size_t current = (entry->bytes & ~HEAP_LARGE_BIT) - sizeof(heap_large_t);
+        res = heap_large_realloc(entry, size);
+        heap_profile_alloc(res != NULL ? res : ptr, res != NULL ? size : current, __builtin_return_address(0));
+        return res;
+    }
+    size_t flags = heap_irq_save();
+    size_t current = heap.BlockSize(ptr);
+    bool resized = size < HEAP_LARGE_MIN && heap.Resize(ptr, size);
+    heap_irq_restore(flags);
+    if (resized) {
+        heap_profile_free(ptr);
+        heap_profile_alloc(ptr, size, __builtin_return_address(0));
+        return ptr;
+    }
+    // Moving costs a copy, made once the heap is free for others again
+    res = heap_alloc(size, __builtin_return_address(0));
+    if (res != NULL) {
+        memcpy(res, ptr, current < size ? current : size);
+        free(ptr);
+    }
+    return res;
+}
+
+void *calloc(size_t count, size_t size)
+{
+    if (size != 0 && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    void *ptr = heap_alloc(count * size, __builtin_return_address(0));
+    if (ptr != NULL) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    heap_profile_free(ptr);
+    heap_large_t *entry = heap_large_find(ptr);
+    if (entry != NULL) {
+        heap_large_free(entry);
+        return;
+    }
+    size_t flags = heap_irq_save();
+    heap.Free(ptr);
+    heap_irq_restore(flags);
+}
+
+}
+
+#endif /* HEAP_TLSF */
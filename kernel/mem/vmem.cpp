@@ -0,0 +1,390 @@
+/**
+ * @file vmem.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Virtual address space arena
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <mem/vmem.hpp>
+#include <sys/panic.hpp>
+
+// Function prototypes
+static inline vmem_segment_t*& tree_left(vmem_segment_t* seg, size_t tree);
+static inline vmem_segment_t*& tree_right(vmem_segment_t* seg, size_t tree);
+static inline int32_t tree_height(vmem_segment_t* seg, size_t tree);
+static inline void tree_update(vmem_segment_t* seg, size_t tree);
+static inline bool tree_less(vmem_segment_t* a, vmem_segment_t* b, size_t tree);
+static vmem_segment_t* tree_rotate_left(vmem_segment_t* seg, size_t tree);
+static vmem_segment_t* tree_rotate_right(vmem_segment_t* seg, size_t tree);
+static vmem_segment_t* tree_balance(vmem_segment_t* seg, size_t tree);
+static vmem_segment_t* tree_insert(vmem_segment_t* root, vmem_segment_t* seg, size_t tree);
+static vmem_segment_t* tree_remove_min(vmem_segment_t* root, vmem_segment_t** min, size_t tree);
+static vmem_segment_t* tree_remove(vmem_segment_t* root, vmem_segment_t* seg, size_t tree);
+static vmem_segment_t* find_at_or_before(vmem_segment_t* root, uintptr_t base);
+static vmem_segment_t* find_after(vmem_segment_t* root, uintptr_t base);
+static vmem_segment_t* find_fit(vmem_segment_t* root, size_t size, uintptr_t base);
+
+static inline vmem_segment_t*& tree_left(vmem_segment_t* seg, size_t tree)
+{
+    return seg->links[tree].left;
+}
+
+static inline vmem_segment_t*& tree_right(vmem_segment_t* seg, size_t tree)
+{
+    return seg->links[tree].right;
+}
+
+static inline int32_t tree_height(vmem_segment_t* seg, size_t tree)
+{
+    return seg ? seg->links[tree].height : 0;
+}
+
+static inline void tree_update(vmem_segment_t* seg, size_t tree)
+{
+    int32_t lh = tree_height(tree_left(seg, tree), tree);
+    int32_t rh = tree_height(tree_right(seg, tree), tree);
+    seg->links[tree].height = (lh > rh ? lh : rh) + 1;
+}
+
+static inline bool tree_less(vmem_segment_t* a, vmem_segment_t* b, size_t tree)
+{
+    if (tree == VMEM_TREE_SIZE && a->size != b->size) {
+        return a->size < b->size;
+    }
+    return a->base < b->base;
+}
+
+static vmem_segment_t* tree_rotate_left(vmem_segment_t* seg, size_t tree)
+{
+    vmem_segment_t* right = tree_right(seg, tree);
+    tree_right(seg, tree) = tree_left(right, tree);
+    tree_left(right, tree) = seg;
+    tree_update(seg, tree);
+    tree_update(right, tree);
+    return right;
+}
+
+static vmem_segment_t* tree_rotate_right(vmem_segment_t* seg, size_t tree)
+{
+    vmem_segment_t* left = tree_left(seg, tree);
+    tree_left(seg, tree) = tree_right(left, tree);
+    tree_right(left, tree) = seg;
+    tree_update(seg, tree);
+    tree_update(left, tree);
+    return left;
+}
+
+static vmem_segment_t* tree_balance(vmem_segment_t* seg, size_t tree)
+{
+    vmem_segment_t* left = tree_left(seg, tree);
+    vmem_segment_t* right = tree_right(seg, tree);
+    int32_t lh = tree_height(left, tree);
+    int32_t rh = tree_height(right, tree);
+    if (lh > rh + 1) {
+        if (tree_height(tree_left(left, tree), tree) < tree_height(tree_right(left, tree), tree)) {
+            tree_left(seg, tree) = tree_rotate_left(left, tree);
+        }
+        return tree_rotate_right(seg, tree);
+    }
+    if (rh > lh + 1) {
+        if (tree_height(tree_right(right, tree), tree) < tree_height(tree_left(right, tree), tree)) {
+            tree_right(seg, tree) = tree_rotate_right(right, tree);
+        }
+        return tree_rotate_left(seg, tree);
+    }
+    tree_update(seg, tree);
+    return seg;
+}
+
+static vmem_segment_t* tree_insert(vmem_segment_t* root, vmem_segment_t* seg, size_t tree)
+{
+    if (root == NULL) {
+        seg->links[tree] = { .left = NULL, .right = NULL, .height = 1 };
+        return seg;
+    }
+    if (tree_less(seg, root, tree)) {
+        tree_left(root, tree) = tree_insert(tree_left(root, tree), seg, tree);
+    } else {
+        tree_right(root, tree) = tree_insert(tree_right(root, tree), seg, tree);
+    }
+    return tree_balance(root, tree);
+}
+
+static vmem_segment_t* tree_remove_min(vmem_segment_t* root, vmem_segment_t** min, size_t tree)
+{
+    if (tree_left(root, tree) == NULL) {
+        *min = root;
+        return tree_right(root, tree);
+    }
+    tree_left(root, tree) = tree_remove_min(tree_left(root, tree), min, tree);
+    return tree_balance(root, tree);
+}
+
+static vmem_segment_t* tree_remove(vmem_segment_t* root, vmem_segment_t* seg, size_t tree)
+{
+    if (root == NULL) {
+        PANIC("Virtual memory segment is missing from its tree.\n");
+    }
+    if (root == seg) {
+        vmem_segment_t* left = tree_left(seg, tree);
+        vmem_segment_t* right = tree_right(seg, tree);
+        if (right == NULL) {
+            return left;
+        }
+        // Put the in-order successor where the segment used to be
+        vmem_segment_t* min;
+        right = tree_remove_min(right, &min, tree);
+        tree_left(min, tree) = left;
+        tree_right(min, tree) = right;
+        return tree_balance(min, tree);
+    }
+    if (tree_less(seg, root, tree)) {
+        tree_left(root, tree) = tree_remove(tree_left(root, tree), seg, tree);
+    } else {
+        tree_right(root, tree) = tree_remove(tree_right(root, tree), seg, tree);
+    }
+    return tree_balance(root, tree);
+}
+
+static vmem_segment_t* find_at_or_before(vmem_segment_t* root, uintptr_t base)
+{
+    // Last segment starting at or before base
+    vmem_segment_t* found = NULL;
+    while (root) {
+        if (root->base <= base) {
+            found = root;
+            root = tree_right(root, VMEM_TREE_ADDR);
+        } else {
+            root = tree_left(root, VMEM_TREE_ADDR);
+        }
+    }
+    return found;
+}
+
+static vmem_segment_t* find_after(vmem_segment_t* root, uintptr_t base)
+{
+    // First segment starting after base
+    vmem_segment_t* found = NULL;
+    while (root) {
+        if (root->base > base) {
+            found = root;
+            root = tree_left(root, VMEM_TREE_ADDR);
+        } else {
+            root = tree_right(root, VMEM_TREE_ADDR);
+        }
+    }
+    return found;
+}
+
+static vmem_segment_t* find_fit(vmem_segment_t* root, size_t size, uintptr_t base)
+{
+    // First segment ordered at or after (size, base) in the size tree
+    vmem_segment_t* found = NULL;
+    while (root) {
+        if (root->size > size || (root->size == size && root->base >= base)) {
+            found = root;
+            root = tree_left(root, VMEM_TREE_SIZE);
+        } else {
+            root = tree_right(root, VMEM_TREE_SIZE);
+        }
+    }
+    return found;
+}
+
+VmemArena::VmemArena()
+    : VmemArena(1)
+{
+}
+
+VmemArena::VmemArena(size_t granularity)
+    : spare(NULL)
+    , spareCount(0)
+    , quantum(granularity)
+    , freeSize(0)
+    , freeSegments(0)
+{
+    if (quantum == 0 || (quantum & (quantum - 1))) {
+        PANIC("Virtual memory arena quantum must be a power of two.\n");
+    }
+    for (size_t i = 0; i < VMEM_TREES; i++) {
+        roots[i] = NULL;
+    }
+}
+
+vmem_segment_t* VmemArena::TakeSpare()
+{
+    vmem_segment_t* seg = spare;
+    if (seg != NULL) {
+        spare = seg->links[VMEM_TREE_ADDR].left;
+        spareCount--;
+    }
+    return seg;
+}
+
+void VmemArena::GiveSpare(vmem_segment_t* seg)
+{
+    seg->links[VMEM_TREE_ADDR].left = spare;
+    spare = seg;
+    spareCount++;
+}
+
+void VmemArena::AddSegments(void* buf, size_t size)
+{
+    uintptr_t start = (uintptr_t)buf;
+    uintptr_t aligned = (start + alignof(vmem_segment_t) - 1) & ~(alignof(vmem_segment_t) - 1);
+    if (aligned - start >= size) {
+        return;
+    }
+    vmem_segment_t* segs = (vmem_segment_t*)aligned;
+    size_t count = (size - (aligned - start)) / sizeof(vmem_segment_t);
+    for (size_t i = 0; i < count; i++) {
+        GiveSpare(&segs[i]);
+    }
+}
+
+void VmemArena::Insert(vmem_segment_t* seg)
+{
+    for (size_t tree = 0; tree < VMEM_TREES; tree++) {
+        roots[tree] = tree_insert(roots[tree], seg, tree);
+    }
+    freeSegments++;
+}
+
+void VmemArena::Remove(vmem_segment_t* seg)
+{
+    for (size_t tree = 0; tree < VMEM_TREES; tree++) {
+        roots[tree] = tree_remove(roots[tree], seg, tree);
+    }
+    freeSegments--;
+}
+
+void VmemArena::Carve(vmem_segment_t* seg, uintptr_t base, size_t size)
+{
+    size_t lead = base - seg->base;
+    size_t trail = (seg->base + seg->size) - (base + size);
+    // The size key is about to change
+    roots[VMEM_TREE_SIZE] = tree_remove(roots[VMEM_TREE_SIZE], seg, VMEM_TREE_SIZE);
+    if (lead) {
+        seg->size = lead;
+        roots[VMEM_TREE_SIZE] = tree_insert(roots[VMEM_TREE_SIZE], seg, VMEM_TREE_SIZE);
+        if (trail) {
+            vmem_segment_t* tail = TakeSpare();
+            tail->base = base + size;
+            tail->size = trail;
+            Insert(tail);
+        }
+    } else if (trail) {
+        // Nothing lies between the old and the new start,
+        // so the segment keeps its place in the address tree
+        seg->base = base + size;
+        seg->size = trail;
+        roots[VMEM_TREE_SIZE] = tree_insert(roots[VMEM_TREE_SIZE], seg, VMEM_TREE_SIZE);
+    } else {
+        roots[VMEM_TREE_ADDR] = tree_remove(roots[VMEM_TREE_ADDR], seg, VMEM_TREE_ADDR);
+        freeSegments--;
+        GiveSpare(seg);
+    }
+    freeSize -= size;
+}
+
+uintptr_t VmemArena::Alloc(size_t size, size_t align)
+{
+    if (size == 0 || (align & (align - 1))) {
+        return VMEM_FAILED;
+    }
+    size = (size + quantum - 1) & ~(quantum - 1);
+    if (align < quantum) {
+        align = quantum;
+    }
+    // Walk up from the smallest segment that is big enough until the
+    // alignment works out. Quantum aligned requests always fit first try.
+    vmem_segment_t* seg = find_fit(roots[VMEM_TREE_SIZE], size, 0);
+    while (seg) {
+        uintptr_t start = (seg->base + align - 1) & ~(align - 1);
+        if (start >= seg->base && start - seg->base <= seg->size - size) {
+            // Splitting off both ends needs an extra descriptor
+            if (start != seg->base && start + size != seg->base + seg->size && spareCount == 0) {
+                return VMEM_FAILED;
+            }
+            Carve(seg, start, size);
+            return start;
+        }
+        seg = find_fit(roots[VMEM_TREE_SIZE], seg->size, seg->base + 1);
+    }
+    return VMEM_FAILED;
+}
+
+void VmemArena::Free(uintptr_t base, size_t size)
+{
+    if (size == 0) {
+        return;
+    }
+    if (base & (quantum - 1)) {
+        PANIC("Attempted to free an unaligned virtual address range.\n");
+    }
+    size = (size + quantum - 1) & ~(quantum - 1);
+    vmem_segment_t* prev = find_at_or_before(roots[VMEM_TREE_ADDR], base);
+    vmem_segment_t* next = find_after(roots[VMEM_TREE_ADDR], base);
+    if ((prev && prev->base + prev->size > base) || (next && next->base < base + size)) {
+        PANIC("Attempted to free a virtual address range that is already free.\n");
+    }
+    bool merge_prev = prev && prev->base + prev->size == base;
+    bool merge_next = next && base + size == next->base;
+    if (merge_prev && merge_next) {
+        roots[VMEM_TREE_SIZE] = tree_remove(roots[VMEM_TREE_SIZE], prev, VMEM_TREE_SIZE);
+        Remove(next);
+        prev->size += size + next->size;
+        roots[VMEM_TREE_SIZE] = tree_insert(roots[VMEM_TREE_SIZE], prev, VMEM_TREE_SIZE);
+        GiveSpare(next);
+    } else if (merge_prev) {
+        roots[VMEM_TREE_SIZE] = tree_remove(roots[VMEM_TREE_SIZE], prev, VMEM_TREE_SIZE);
+        prev->size += size;
+        roots[VMEM_TREE_SIZE] = tree_insert(roots[VMEM_TREE_SIZE], prev, VMEM_TREE_SIZE);
+    } else if (merge_next) {
+        roots[VMEM_TREE_SIZE] = tree_remove(roots[VMEM_TREE_SIZE], next, VMEM_TREE_SIZE);
+        next->base = base;
+        next->size += size;
+        roots[VMEM_TREE_SIZE] = tree_insert(roots[VMEM_TREE_SIZE], next, VMEM_TREE_SIZE);
+    } else {
+        vmem_segment_t* seg = TakeSpare();
+        if (seg == NULL) {
+            PANIC("Out of virtual memory segment descriptors.\n");
+        }
+        seg->base = base;
+        seg->size = size;
+        Insert(seg);
+    }
+    freeSize += size;
+}
+
+bool VmemArena::Reserve(uintptr_t base, size_t size)
+{
+    if (size == 0 || (base & (quantum - 1))) {
+        return false;
+    }
+    size = (size + quantum - 1) & ~(quantum - 1);
+    vmem_segment_t* seg = find_at_or_before(roots[VMEM_TREE_ADDR], base);
+    if (seg == NULL || seg->base + seg->size <= base || seg->base + seg->size - base < size) {
+        return false;
+    }
+    if (seg->base != base && base + size != seg->base + seg->size && spareCount == 0) {
+        return false;
+    }
+    Carve(seg, base, size);
+    return true;
+}
+
+size_t VmemArena::LargestFree()
+{
+    vmem_segment_t* seg = roots[VMEM_TREE_SIZE];
+    if (seg == NULL) {
+        return 0;
+    }
+    while (tree_right(seg, VMEM_TREE_SIZE)) {
+        seg = tree_right(seg, VMEM_TREE_SIZE);
+    }
+    return seg->size;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file vmem.hpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Virtual address space arena
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <meta/compiler.hpp>
+
+// Returned by the arena when a request cannot be satisfied
+#define VMEM_FAILED     UINTPTR_MAX
+// Free segments are indexed by address and by size
+#define VMEM_TREE_ADDR  0
+#define VMEM_TREE_SIZE  1
+#define VMEM_TREES      2
+
+/**
+ * @brief Describes one free extent of the arena. Segments are linked into
+ * an AVL tree ordered by address (for coalescing) and another ordered by
+ * size then address (for best-fit allocation).
+ */
+typedef struct vmem_segment {
+    uintptr_t base;
+    size_t size;
+    struct vmem_link {
+        struct vmem_segment* left;
+        struct vmem_segment* right;
+        int32_t height;
+    } links[VMEM_TREES];
+} vmem_segment_t;
+
+/**
+ * @brief A vmem-style arena which hands out ranges of an address space.
+ * Only the free extents are tracked. Allocations pick the smallest extent
+ * that fits (best-fit), so both allocating and freeing are O(log n) in the
+ * number of free extents. Freed ranges are coalesced with their neighbours.
+ * Segment descriptors come from caller-provided buffers (see AddSegments())
+ * so that the arena can sit underneath the kernel heap.
+ */
+class VmemArena {
+public:
+    VmemArena();
+    /**
+     * @brief Construct a new, empty arena.
+     *
+     * @param granularity Allocation granularity. Every size and alignment
+     * is rounded up to a multiple of it. Must be a power of two.
+     */
+    VmemArena(size_t granularity);
+    /**
+     * @brief Donates memory to be used for segment descriptors.
+     *
+     * @param buf Buffer to carve descriptors out of
+     * @param size Size of the buffer in bytes
+     */
+    void AddSegments(void* buf, size_t size);
+    /**
+     * @brief Adds a range of addresses to the arena. The range must not
+     * overlap anything the arena already knows about.
+     *
+     * @param base Start of the range
+     * @param size Size of the range in bytes
+     */
+    ALWAYS_INLINE void Add(uintptr_t base, size_t size) { Free(base, size); }
+    /**
+     * @brief Allocates a range of addresses.
+     *
+     * @param size Size of the range in bytes
+     * @param align Required alignment of the start of the range (a power of two)
+     * @return uintptr_t Start of the range or VMEM_FAILED
+     */
+    uintptr_t Alloc(size_t size, size_t align);
+    /**
+     * @brief Returns a range of addresses to the arena.
+     *
+     * @param base Start of the range
+     * @param size Size of the range in bytes
+     */
+    void Free(uintptr_t base, size_t size);
+    /**
+     * @brief Allocates a specific range of addresses.
+     *
+     * @param base Start of the range
+     * @param size Size of the range in bytes
+     * @return true The range was free and now belongs to the caller
+     * @return false Part of the range is not free
+     */
+    bool Reserve(uintptr_t base, size_t size);
+    /**
+     * @brief Returns the size of the largest free extent.
+     *
+     * @return size_t Size in bytes
+     */
+    size_t LargestFree();
+    ALWAYS_INLINE size_t Quantum() { return quantum; }
+    ALWAYS_INLINE size_t FreeSize() { return freeSize; }
+    ALWAYS_INLINE size_t FreeSegments() { return freeSegments; }
+    ALWAYS_INLINE size_t SpareSegments() { return spareCount; }
+
+private:
+    vmem_segment_t* roots[VMEM_TREES];
+    vmem_segment_t* spare;
+    size_t spareCount;
+    size_t quantum;
+    size_t freeSize;
+    size_t freeSegments;
+
+    vmem_segment_t* TakeSpare();
+    void GiveSpare(vmem_segment_t* seg);
+    void Insert(vmem_segment_t* seg);
+    void Remove(vmem_segment_t* seg);
+    void Carve(vmem_segment_t* seg, uintptr_t base, size_t size);
+};
@@ -0,0 +1,202 @@
+/**
+ * @file zero_pool.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Pool of pre-zeroed frames refilled while the processor is idle
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <mem/zero_pool.hpp>
+#include <mem/paging.hpp>
+#include <mem/frames.hpp>
+#include <lib/mutex.hpp>
+#include <dev/serial/rs232.hpp>
+#include <cpuid.h>
+
+// CPUID leaf 1 EDX bit advertising SSE2 (and so movnti)
+#define CPUID_FEAT_EDX_SSE2 (1 << 26)
+
+// Both stacks are shared with the idle loop and the page fault task and
+// only touched with interrupts disabled. The lock only keeps refills from
+// racing.
+static size_t clean_frames[ZERO_POOL_FRAMES];
+static size_t dirty_frames[ZERO_POOL_FRAMES];
+static size_t clean_count = 0;
+static size_t dirty_count = 0;
+static size_t pool_hits = 0;
+static size_t pool_misses = 0;
+static int pool_sse2 = -1;
+static mutex_t lock("zero_pool");
+
+// Function prototypes
+static inline size_t zero_pool_irq_save();
+static inline void zero_pool_irq_restore(size_t flags);
+static void zero_pool_zero(void *page, bool cached);
+
+#ifdef TESTING
+// Unit tests run in user mode and have no interrupts to hold off
+static inline size_t zero_pool_irq_save() { return 0; }
+static inline void zero_pool_irq_restore(size_t flags) { (void)flags; }
+#else
+static inline size_t zero_pool_irq_save()
+{
+    size_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r"(flags) :: "memory");
+    return flags;
+}
+
+static inline void zero_pool_irq_restore(size_t flags)
+{
+    asm volatile("push %0; popf" :: "r"(flags) : "memory", "cc");
+}
+#endif
+
+static void zero_pool_zero(void *page, bool cached)
+{
+    if (pool_sse2 < 0) {
+        unsigned int eax, ebx, ecx, edx;
+        pool_sse2 = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & CPUID_FEAT_EDX_SSE2);
+    }
+    uint32_t *dst = (uint32_t *)page;
+    if (cached || !pool_sse2) {
+        size_t count = PAGE_SIZE / sizeof(uint32_t);
+        asm volatile("rep stosl" : "+D"(dst), "+c"(count) : "a"(0) : "memory");
+        return;
+    }
+    // Non-temporal stores go straight to memory instead of evicting
+    // whatever the next task has in the cache. movnti works on general
+    // purpose registers, so no SSE state is touched either.
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(uint32_t); i += 4) {
+        asm volatile(
+            "movnti %1, 0(%0)\n"
+            "movnti %1, 4(%0)\n"
+            "movnti %1, 8(%0)\n"
+            "movnti %1, 12(%0)\n"
+            :: "r"(dst + i), "r"(0) : "memory");
+    }
+    // Make the stores visible before the page is handed out
+    asm volatile("sfence" ::: "memory");
+}
+
+void zero_pool_refill()
+{
+    // Read without the lock, a stale count only delays the refill
+    if (clean_count + dirty_count >= ZERO_POOL_LOW) {
+        return;
+    }
+    mutex_lock(&lock);
+    while (true) {
+        size_t flags = zero_pool_irq_save();
+        size_t frame = clean_count + dirty_count < ZERO_POOL_FRAMES ? frames_alloc() : SIZE_MAX;
+        if (frame != SIZE_MAX) {
+            dirty_frames[dirty_count++] = frame;
+        }
+        zero_pool_irq_restore(flags);
+        if (frame == SIZE_MAX) {
+            break;
+        }
+    }
+    mutex_unlock(&lock);
+}
+
+size_t get_zeroed_frame()
+{
+    size_t flags = zero_pool_irq_save();
+    size_t frame = SIZE_MAX;
+    if (clean_count > 0) {
+        frame = clean_frames[--clean_count];
+        pool_hits++;
+        // the new owner is about to write to it
+        frame_clear_flags(frame, FRAME_ZEROED);
+    } else {
+        pool_misses++;
+    }
+    zero_pool_irq_restore(flags);
+    if (frame != SIZE_MAX) {
+        return frame;
+    }
+    frame = frames_alloc();
+    if (frame == SIZE_MAX) {
+        return SIZE_MAX;
+    }
+    void *page = kmap_temp(FRAME_TO_PHYS(frame));
+    if (page == NULL) {
+        frames_free(frame);
+        return SIZE_MAX;
+    }
+    // about to be used, so zero it through the cache
+    zero_pool_zero(page, true);
+    kunmap_temp(page);
+    return frame;
+}
+
+bool zero_pool_idle()
+{
+    // Runs with interrupts off, so nothing else touches the pool meanwhile
+    if (dirty_count == 0) {
+        return false;
+    }
+    size_t frame = dirty_frames[dirty_count - 1];
+    void *page = kmap_temp(FRAME_TO_PHYS(frame));
+    if (page == NULL) {
+        // every temporary mapping is in use, try again later
+        return false;
+    }
+    zero_pool_zero(page, false);
+    kunmap_temp(page);
+    frame_set_flags(frame, FRAME_ZEROED);
+    dirty_count--;
+    clean_frames[clean_count++] = frame;
+    return true;
+}
+
+void zero_pool_get_stats(zero_pool_stats_t *stats)
+{
+    size_t flags = zero_pool_irq_save();
+    stats->hits = pool_hits;
+    stats->misses = pool_misses;
+    stats->clean = clean_count;
+    stats->dirty = dirty_count;
+    zero_pool_irq_restore(flags);
+}
+
+size_t zero_pool_reclaimable()
+{
+    return clean_count + dirty_count;
+}
+
+size_t zero_pool_shrink(size_t pages)
+{
+    // Skipped while refilling, since that is an allocation in progress
+    if (mutex_trylock(&lock) != 0) {
+        return 0;
+    }
+    size_t freed = 0;
+    while (freed < pages) {
+        size_t flags = zero_pool_irq_save();
+        size_t frame = SIZE_MAX;
+        if (dirty_count > 0) {
+            frame = dirty_frames[--dirty_count];
+        } else if (clean_count > 0) {
+            frame = clean_frames[--clean_count];
+        }
+        zero_pool_irq_restore(flags);
+        if (frame == SIZE_MAX) {
+            break;
+        }
+        frames_free(frame);
+        freed++;
+    }
+    mutex_unlock(&lock);
+    return freed;
+}
+
+void zero_pool_print_stats()
+{
+    zero_pool_stats_t stats;
+    zero_pool_get_stats(&stats);
+    rs232::printf("zero pool: %u hits, %u misses, %u frames zeroed, %u waiting\n",
+        stats.hits, stats.misses, stats.clean, stats.dirty);
+}
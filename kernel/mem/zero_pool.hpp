@@ -0,0 +1,83 @@
+/**
+ * @file zero_pool.hpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Pool of pre-zeroed frames refilled while the processor is idle
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Frames held by the pool, zeroed or waiting to be zeroed
+#define ZERO_POOL_FRAMES    64
+// The pool is topped up once fewer frames than this are left in it
+#define ZERO_POOL_LOW       16
+
+typedef struct zero_pool_stats {
+    size_t hits;        // Requests served with a frame zeroed ahead of time
+    size_t misses;      // Requests that found no zeroed frame
+    size_t clean;       // Zeroed frames ready to be handed out
+    size_t dirty;       // Frames waiting for the idle loop to zero them
+} zero_pool_stats_t;
+
+/**
+ * @brief Gets a zeroed frame, preferably one zeroed in idle time. Only when
+ * the pool is empty is a frame allocated and zeroed on the spot. No locks
+ * are taken, so the page fault task may use it too. The frame has
+ * FRAME_ZEROED cleared, since its new owner is about to write to it, and
+ * is freed with frames_free() like any other.
+ *
+ * @return size_t Zeroed frame or SIZE_MAX if out of frames
+ */
+size_t get_zeroed_frame();
+
+/**
+ * @brief Tops the pool up with frames for the idle loop to zero once it
+ * has run low. Must be called from a task.
+ *
+ */
+void zero_pool_refill();
+
+/**
+ * @brief Zeroes one pooled frame. Called by the scheduler with interrupts
+ * disabled while there is nothing to run, so it neither blocks nor allocates.
+ *
+ * @return true A frame was zeroed
+ * @return false Every pooled frame is zeroed already
+ */
+bool zero_pool_idle();
+
+/**
+ * @brief Gets the pool counters.
+ *
+ * @param stats Filled in with the current counters
+ */
+void zero_pool_get_stats(zero_pool_stats_t *stats);
+
+/**
+ * @brief Prints the pool counters over serial.
+ *
+ */
+void zero_pool_print_stats();
+
+/**
+ * @brief Counts the frames held by the pool.
+ *
+ * @return size_t Frames that zero_pool_shrink() could give back
+ */
+size_t zero_pool_reclaimable();
+
+/**
+ * @brief Gives frames held by the pool back to the frame allocator, the
+ * ones still waiting to be zeroed first. Returns right away if the pool is
+ * being refilled.
+ *
+ * @param pages Most frames to give back
+ * @return size_t Frames given back
+ */
+size_t zero_pool_shrink(size_t pages);
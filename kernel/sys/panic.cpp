@@ -16,13 +16,29 @@
 #include <dev/serial/rs232.hpp>
 #include <lib/string.hpp>
 #include <lib/stdio.hpp>
+#include <mem/arena.hpp>
+
+// Room for every message buffer used while panicking
+#define PANIC_SCRATCH_SIZE 2048
+
+// Task stacks are small and may be what overflowed, so the messages are
+// put together in a static buffer instead
+static uint8_t panic_scratch[PANIC_SCRATCH_SIZE] __attribute__ ((aligned (ARENA_ALIGN)));
+static arena_t panic_arena;
 
 // Function prototypes
+static void panic_init_scratch();
 void printPanicScreen(int exception);
 void panic_print_file(const char *file, uint32_t line, const char *func);
 void panic_print_register(registers_t *regs);
 
+static void panic_init_scratch() {
+    // Starts over if we panic while panicking
+    arena_init_fixed(&panic_arena, "panic", panic_scratch, sizeof(panic_scratch));
+}
+
 void printPanicScreen(int exception) {
+    ArenaScope scope(&panic_arena);
     tty_clear(VGA_Black, VGA_White);
     const char* tag;
     if (exception == 13) {
@@ -30,7 +46,7 @@ void printPanicScreen(int exception) {
     } else {
         tag = "< OH NO! Panix panicked! >\n";
     }
-    char cow[256];
+    char *cow = (char *)scope.Alloc(256);
     ksprintf(
         cow,
         " ________________________\n"
@@ -50,10 +66,11 @@ void printPanicScreen(int exception) {
 
 NORET void panic(const char* msg, const char *file, uint32_t line, const char *func) {
     asm volatile ("cli");
+    panic_init_scratch();
     // Print the panic cow
     printPanicScreen(0);
     // Print the message passed in on a new line
-    char buf[128];
+    char *buf = (char *)arena_alloc(&panic_arena, 128);
     ksprintf(buf, "\n%s\n", msg);
     // Print to VGA and serial
     kprintf("%s", buf);
@@ -67,9 +84,10 @@ NORET void panic(const char* msg, const char *file, uint32_t line, const char *f
 
 NORET void panic(registers_t *regs, const char *file, uint32_t line, const char *func) {
     asm volatile ("cli");
+    panic_init_scratch();
     // Print the panic cow and exception description
     printPanicScreen(regs->int_num);
-    char msg[128];
+    char *msg = (char *)arena_alloc(&panic_arena, 128);
     ksprintf(
         msg,
         "Exception: %i (%s)\n\n",
@@ -131,7 +149,8 @@ NORET void panic(registers_t *regs, const char *file, uint32_t line, const char
 }
 
 void panic_print_file(const char *file, uint32_t line, const char *func) {
-    char msg[128];
+    ArenaScope scope(&panic_arena);
+    char *msg = (char *)scope.Alloc(128);
     ksprintf(
         msg,
         "Crash location may be inaccurate.\n"
@@ -151,7 +170,8 @@ void panic_print_register(registers_t *regs) {
     // colors each time (to print the numbers in back) since I can't just call
     // reset (because it would reset to a black background w/ white text, which
     // is the inverse of what we want.)
-    char msg[512];
+    ArenaScope scope(&panic_arena);
+    char *msg = (char *)scope.Alloc(512);
 
     #if defined(__i386__) | defined(__i686__)
     ksprintf(
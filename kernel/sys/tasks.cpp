@@ -10,6 +10,8 @@
  */
 #include <sys/tasks.hpp>
 #include <mem/heap.hpp>
+#include <mem/slab.hpp>
+#include <mem/zero_pool.hpp>
 #include <sys/panic.hpp>
 #include <lib/stdio.hpp>
 #include <dev/serial/rs232.hpp>
@@ -36,8 +38,10 @@ void _wakeup(task_t *task);
         return _dequeue_task(&tasks_##name); }
 
 task_t *current_task = NULL;
+static kmem_cache_t *_task_cache = NULL;
 static task_t _cleaner_task;
 static task_t _first_task;
+static arena_t _boot_arena;
 
 tasklist_t tasks_ready = { /* Zero */ };
 NAMED_TASKLIST(sleeping);
@@ -169,8 +173,22 @@ void tasks_init()
         .name = "[main]",
         // this is not backed by dynamic memory
         .alloc = ALLOC_STATIC,
+        // still running on the boot stack
+        .stack = NULL,
+        // kernel tasks share the kernel's address space
+        .space = NULL,
+        // set up below
+        .arena = { },
     };
+    // whatever boot code left in the boot arena is handed over to this task
+    this_task->arena = _boot_arena;
+    if (this_task->arena.name == NULL) arena_init(&this_task->arena, "[main]");
     TASK_ACTION("create task", this_task);
+    // dynamically allocated tasks come from their own slab cache
+    _task_cache = kmem_cache_create("task", sizeof(task_t), 0, NULL);
+    if (_task_cache == NULL) {
+        PANIC("Unable to create the task cache.\n");
+    }
     // create a task for the cleaner and set it's state to "paused"
     (void) tasks_new(_cleaner_task_impl, &_cleaner_task, TASK_PAUSED, "[cleaner]");
     _cleaner_task.state = TASK_PAUSED;
@@ -284,22 +302,23 @@ static task_t *_tasks_dequeue_ready()
     return _dequeue_task(&tasks_ready);
 }
 
-task_t *tasks_new(void (*entry)(void), task_t *storage, task_state state, const char *name)
+task_t *tasks_new(void (*entry)(void), task_t *storage, task_state state, const char *name,
+    address_space_t *space)
 {
     task_t *new_task = storage;
     if (storage == NULL) {
         // allocate memory for our task structure
-        new_task = (task_t*)malloc(sizeof(task_t));
+        new_task = (task_t*)kmem_cache_alloc(_task_cache);
         // panic if the alloc fails (we have no fallback)
         if (new_task == NULL) {
             PANIC("Unable to allocate memory for new task struct.\n");
         }
     }
-    // allocate a page for this stack (we might change this later)
-    uint8_t *stack = (uint8_t *)get_new_page(PAGE_SIZE - 1);
+    // reserve a guarded stack, only the top page is backed for now
+    void *stack = get_new_stack(TASK_STACK_SIZE_MAX);
     if (stack == NULL) PANIC("Unable to allocate memory for new task stack.\n");
-    // remember, the stack grows up
-    void *stack_pointer = stack + PAGE_SIZE;
+    // remember, the stack grows down
+    void *stack_pointer = stack;
     // a null stack frame to make the panic screen happy
     _stack_push_word(&stack_pointer, 0);
     // the last thing to happen is the task stopping function
@@ -315,12 +334,16 @@ task_t *tasks_new(void (*entry)(void), task_t *storage, task_state state, const
     _stack_push_word(&stack_pointer, 0);
     _stack_push_word(&stack_pointer, 0);
     new_task->stack_top = (uintptr_t)stack_pointer;
-    new_task->page_dir = get_phys_page_dir();
+    if (space != NULL) address_space_get(space);
+    new_task->page_dir = space != NULL ? space->dir_phys : get_phys_page_dir();
+    new_task->space = space;
+    arena_init(&new_task->arena, name);
     new_task->next = NULL;
     new_task->state = state;
     new_task->time_used = 0;
     new_task->name = name;
     new_task->alloc = storage == NULL ? ALLOC_DYNAMIC : ALLOC_STATIC;
+    new_task->stack = stack;
     if (state == TASK_READY) {
         _tasks_enqueue_ready(new_task);
     }
@@ -372,10 +395,18 @@ static void _schedule()
         current_task = NULL;
         _idle_start = _get_cpu_time_ns();
         do {
+            // zero a page for the pool while interrupts are still off,
+            // the CPU only halts once there is nothing left to zero
+            bool zeroed = zero_pool_idle();
             // enable interrupts to process timer and other events
             asm ("sti");
-            // immediately halt the CPU
-            asm ("hlt");
+            if (zeroed) {
+                // give pending interrupts a chance to be taken
+                asm ("nop");
+            } else {
+                // immediately halt the CPU
+                asm ("hlt");
+            }
             // disable interrupts to restore our lock
             asm ("cli");
             // check if there's a task ready to be run
@@ -525,14 +556,27 @@ void tasks_exit()
     _release_scheduler_lock();
 }
 
+arena_t *tasks_get_arena(void)
+{
+    if (current_task != NULL) {
+        return &current_task->arena;
+    }
+    if (_boot_arena.name == NULL) {
+        arena_init(&_boot_arena, "[boot]");
+    }
+    return &_boot_arena;
+}
+
 static void _clean_stopped_task(task_t *task)
 {
-    // free the stack page
-    uintptr_t page = task->stack_top & PAGE_ALIGN;
-    free_page((void *)page, PAGE_SIZE - 1);
+    // free the stack along with every page it grew into
+    free_stack(task->stack, TASK_STACK_SIZE_MAX);
+    // the last task of an address space takes its private mappings along
+    if (task->space != NULL) address_space_release(task->space);
+    arena_release(&task->arena);
     // somehow determine if the task was dynamically allocated or not
     // just assume statically allocated tasks will never exit (bad idea)
-    if (task->alloc == ALLOC_DYNAMIC) free(task);
+    if (task->alloc == ALLOC_DYNAMIC) kmem_cache_free(_task_cache, task);
 }
 
 static void _cleaner_task_impl()
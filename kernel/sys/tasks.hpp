@@ -13,8 +13,13 @@
 #include <stdint.h>         // Data type definitions
 #include <arch/arch.hpp>    // Architecture specific features
 #include <mem/paging.hpp>
+#include <mem/arena.hpp>
 
 #define TIME_SLICE_SIZE (1 * 1000 * 1000ULL)
+// Largest size a task's stack may grow to (pages are committed on demand)
+#ifndef TASK_STACK_SIZE_MAX
+#define TASK_STACK_SIZE_MAX (64 * 1024)
+#endif
 
 enum task_state
 {
@@ -40,6 +45,9 @@ struct task
     uint64_t wakeup_time;
     const char *name;
     task_alloc alloc;
+    void *stack;        // Top of the stack from get_new_stack() (NULL for the boot stack)
+    address_space_t *space; // Private address space (NULL for the kernel's)
+    arena_t arena;      // Scratch memory, released when the task is cleaned up
 };
 
 extern task_t *current_task;
@@ -88,9 +96,11 @@ extern "C" void tasks_switch_to(task_t *task);
  * @param entry Task function entry point
  * @param storage Task stack structure (if NULL, a pointer to the task is returned)
  * @param state Task state structure
+ * @param space Address space to run in, a reference is taken (NULL for the kernel's)
  * @return task_t* Pointer to the created kernel task
  */
-task_t *tasks_new(void (*entry)(void), task_t *storage, task_state state, const char *name);
+task_t *tasks_new(void (*entry)(void), task_t *storage, task_state state, const char *name,
+    address_space_t *space = NULL);
 /**
  * @brief Tell the kernel task scheduler to schedule all of the added tasks.
  *
@@ -131,6 +141,14 @@ void tasks_nano_sleep(uint64_t time);
  *
  */
 void tasks_exit(void);
+/**
+ * @brief Returns the scratch arena of the current task, or a shared boot
+ * arena before tasking is up. Allocations should be made inside an
+ * ArenaScope so that they are gone once the work is done.
+ *
+ * @return arena_t* Arena of the current task
+ */
+arena_t *tasks_get_arena(void);
 
 void tasks_sync_block(tasks_sync_t *tsc);
 
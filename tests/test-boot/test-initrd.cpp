@@ -0,0 +1,133 @@
+/**
+ * @file test-initrd.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Initrd archive reader unit tests
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <catch2/catch.hpp>
+#include <boot/Initrd.cpp>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static void tarAdd(std::vector<uint8_t>& tar, const char* name, const std::string& data, char type = '0')
+{
+    uint8_t header[512] = { 0 };
+    strncpy((char*)header, name, 100);
+    snprintf((char*)header + 124, 12, "%011o", (unsigned)data.size());
+    header[156] = (uint8_t)type;
+    memcpy(header + 257, "ustar", 6);
+    tar.insert(tar.end(), header, header + sizeof(header));
+    tar.insert(tar.end(), data.begin(), data.end());
+    tar.resize((tar.size() + 511) / 512 * 512, 0);
+}
+
+static void cpioAdd(std::vector<uint8_t>& cpio, const char* name, const std::string& data, unsigned mode = 0100644)
+{
+    char header[111];
+    snprintf(header, sizeof(header), "070701%08x%08x%08x%08x%08x%08x%08x%08x%08x%08x%08x%08x%08x",
+        1u, mode, 0u, 0u, 1u, 0u, (unsigned)data.size(), 0u, 0u, 0u, 0u, (unsigned)strlen(name) + 1, 0u);
+    cpio.insert(cpio.end(), header, header + 110);
+    cpio.insert(cpio.end(), name, name + strlen(name) + 1);
+    cpio.resize((cpio.size() + 3) / 4 * 4, 0);
+    cpio.insert(cpio.end(), data.begin(), data.end());
+    cpio.resize((cpio.size() + 3) / 4 * 4, 0);
+}
+
+static std::string fileData(const Boot::initrd_file_t& file)
+{
+    return std::string((const char*)file.data, file.size);
+}
+
+TEST_CASE("initrd tar archives", "[initrd]") {
+    std::vector<uint8_t> tar;
+    tarAdd(tar, "./etc/", "", '5');
+    tarAdd(tar, "./etc/config", "threads=4\n");
+    tarAdd(tar, "./data.bin", std::string(1000, 'x'));
+    tar.resize(tar.size() + 1024, 0);
+    Boot::Initrd initrd(tar.data(), tar.size());
+    REQUIRE(initrd.getFormat() == Boot::InitrdTar);
+    REQUIRE(initrd.getFileCount() == 2);
+
+    SECTION("files are found without copying") {
+        Boot::initrd_file_t file;
+        REQUIRE(initrd.find("/etc/config", &file));
+        REQUIRE(fileData(file) == "threads=4\n");
+        REQUIRE((const uint8_t*)file.data >= tar.data());
+        REQUIRE((const uint8_t*)file.data < tar.data() + tar.size());
+        REQUIRE(initrd.find("data.bin", &file));
+        REQUIRE(file.size == 1000);
+        REQUIRE_FALSE(initrd.find("etc", &file));
+        REQUIRE_FALSE(initrd.find("etc/conf", &file));
+    }
+    SECTION("long paths use the prefix field") {
+        tar.resize(tar.size() - 1024);
+        tarAdd(tar, "file", "abc");
+        memcpy(&tar[tar.size() - 1024 + 345], "some/dir", 8);
+        tar.resize(tar.size() + 1024, 0);
+        Boot::Initrd prefixed(tar.data(), tar.size());
+        Boot::initrd_file_t file;
+        REQUIRE(prefixed.find("some/dir/file", &file));
+        REQUIRE(fileData(file) == "abc");
+        REQUIRE_FALSE(prefixed.find("file", &file));
+    }
+    SECTION("truncated archives stop early") {
+        Boot::Initrd truncated(tar.data(), 512 * 3);
+        Boot::initrd_file_t file;
+        REQUIRE(truncated.find("etc/config", &file));
+        REQUIRE_FALSE(truncated.find("data.bin", &file));
+    }
+}
+
+TEST_CASE("initrd cpio archives", "[initrd]") {
+    std::vector<uint8_t> cpio;
+    cpioAdd(cpio, ".", "", 040755);
+    cpioAdd(cpio, "bench/input", "0123456789");
+    cpioAdd(cpio, "a", "z");
+    cpioAdd(cpio, "TRAILER!!!", "", 0);
+    Boot::Initrd initrd(cpio.data(), cpio.size());
+    REQUIRE(initrd.getFormat() == Boot::InitrdCpio);
+    REQUIRE(initrd.getFileCount() == 2);
+
+    Boot::initrd_file_t file;
+    REQUIRE(initrd.find("./bench/input", &file));
+    REQUIRE(fileData(file) == "0123456789");
+    REQUIRE(initrd.find("a", &file));
+    REQUIRE(fileData(file) == "z");
+    REQUIRE_FALSE(initrd.find("TRAILER!!!", &file));
+
+    SECTION("corrupt headers end the walk") {
+        // the second header follows "." and its padding
+        size_t second = (CPIO_HEADER_SIZE + 2 + CPIO_ALIGN - 1) & ~(size_t)(CPIO_ALIGN - 1);
+        cpio[second + CPIO_SIZE_OFFSET] = 'g';
+        Boot::Initrd corrupt(cpio.data(), cpio.size());
+        REQUIRE(corrupt.getFileCount() == 0);
+    }
+}
+
+TEST_CASE("initrd rejects unknown data", "[initrd]") {
+    std::vector<uint8_t> junk(2048, 0xAB);
+    Boot::Initrd initrd(junk.data(), junk.size());
+    Boot::initrd_file_t file;
+    REQUIRE_FALSE(initrd.isValid());
+    REQUIRE_FALSE(initrd.find("anything", &file));
+    REQUIRE(Boot::Initrd().getFileCount() == 0);
+}
+
+TEST_CASE("initrd boot archive", "[initrd]") {
+    // Nothing was booted with an archive yet
+    REQUIRE_FALSE(Boot::getInitrd().isValid());
+    std::vector<uint8_t> tar;
+    tarAdd(tar, "bench/input", "0123456789");
+    tar.resize(tar.size() + 1024, 0);
+    Boot::setInitrd(Boot::Initrd(tar.data(), tar.size()));
+    Boot::initrd_file_t file;
+    REQUIRE(Boot::getInitrd().find("bench/input", &file));
+    REQUIRE(fileData(file) == "0123456789");
+    Boot::setInitrd(Boot::Initrd());
+}
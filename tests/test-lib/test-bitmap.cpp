@@ -8,8 +8,10 @@
  * @copyright Copyright the Panix Contributors (c) 2021
  *
  */
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include <catch2/catch.hpp>
 #include <lib/bitset.cpp>
+#include <string>
 
 #define TEST_BITMAP_SIZE 4096 / (sizeof(size_t) * CHAR_BIT)
 static size_t bitmapArray[TEST_BITMAP_SIZE];
@@ -18,3 +20,103 @@ TEST_CASE( "Set", "[bitmap]" ) {
     Bitset map = Bitset(bitmapArray, sizeof(bitmapArray));
     (void)map;
 }
+
+#define TEST_SUMMARY_BITS 5000
+static size_t summaryArray[SummaryBitset::StorageWords(TEST_SUMMARY_BITS)];
+
+TEST_CASE( "Summary bitset operations", "[bitmap]" ) {
+    SummaryBitset map = SummaryBitset(summaryArray, TEST_SUMMARY_BITS);
+    REQUIRE(map.Size() == TEST_SUMMARY_BITS);
+    REQUIRE(map.FindFirstBitClear() == 0);
+
+    SECTION("set and clear") {
+        map.Set(70);
+        REQUIRE(map.Get(70));
+        REQUIRE_FALSE(map.Get(69));
+        map.Clear(70);
+        REQUIRE_FALSE(map.Get(70));
+    }
+    SECTION("full words are skipped") {
+        for (size_t i = 0; i < 4000; i++) {
+            map.Set(i);
+        }
+        REQUIRE(map.FindFirstBitClear() == 4000);
+        map.Clear(1234);
+        REQUIRE(map.FindFirstBitClear() == 1234);
+        REQUIRE(map.FindNextBitClear(1235) == 4000);
+        map.Set(1234);
+        REQUIRE(map.FindFirstBitClear() == 4000);
+    }
+    SECTION("bits past the end are never found") {
+        for (size_t i = 0; i < TEST_SUMMARY_BITS; i++) {
+            map.Set(i);
+        }
+        REQUIRE(map.FindFirstBitClear() == SIZE_MAX);
+        REQUIRE(map.FindFirstRangeClear(1) == SIZE_MAX);
+        map.Clear(TEST_SUMMARY_BITS - 1);
+        REQUIRE(map.FindFirstBitClear() == TEST_SUMMARY_BITS - 1);
+        REQUIRE(map.FindFirstRangeClear(2) == SIZE_MAX);
+    }
+    SECTION("ranges longer than a word") {
+        // Leave gaps of 10 and 200 bits between used bits
+        map.Set(0);
+        map.Set(11);
+        map.Set(212);
+        REQUIRE(map.FindFirstRangeClear(10) == 1);
+        REQUIRE(map.FindFirstRangeClear(11) == 12);
+        REQUIRE(map.FindFirstRangeClear(200) == 12);
+        REQUIRE(map.FindFirstRangeClear(201) == 213);
+        REQUIRE(map.FindFirstRangeClear(TEST_SUMMARY_BITS - 213) == 213);
+        REQUIRE(map.FindFirstRangeClear(TEST_SUMMARY_BITS - 212) == SIZE_MAX);
+        REQUIRE(map.FindFirstRangeClear(0) == SIZE_MAX);
+    }
+    SECTION("matches a linear scan") {
+        // Pseudo-random set/clear pattern checked against a plain bit scan
+        uint32_t seed = 12345;
+        for (size_t round = 0; round < 2000; round++) {
+            seed = seed * 1103515245 + 12345;
+            size_t bit = (seed >> 8) % TEST_SUMMARY_BITS;
+            if (round % 3) map.Set(bit); else map.Clear(bit);
+            size_t expected = SIZE_MAX;
+            for (size_t i = 0; i < TEST_SUMMARY_BITS; i++) {
+                if (!map.Get(i)) { expected = i; break; }
+            }
+            REQUIRE(map.FindFirstBitClear() == expected);
+        }
+    }
+}
+
+// One bit per page of a 4 GiB address space, as used by the paging code
+#define BENCH_BITMAP_BITS 0x100000
+static size_t benchBitsetArray[BENCH_BITMAP_BITS / (sizeof(size_t) * CHAR_BIT)];
+static size_t benchSummaryArray[SummaryBitset::StorageWords(BENCH_BITMAP_BITS)];
+
+// Hidden by default, run with: unit-test "[benchmark]"
+TEST_CASE( "Bitset scan benchmark", "[.][benchmark][bitmap]" ) {
+    Bitset bitset = Bitset(benchBitsetArray, BENCH_BITMAP_BITS);
+    SummaryBitset summary = SummaryBitset(benchSummaryArray, BENCH_BITMAP_BITS);
+    for (size_t i = 0; i < BENCH_BITMAP_BITS / (sizeof(size_t) * CHAR_BIT); i++) {
+        benchBitsetArray[i] = 0;
+    }
+    // Bits are used from the bottom up, like the first-fit page allocator does
+    size_t occupancy = GENERATE(10, 50, 95);
+    size_t used = BENCH_BITMAP_BITS / 100 * occupancy;
+    for (size_t i = 0; i < used; i++) {
+        bitset.Set(i);
+        summary.Set(i);
+    }
+    REQUIRE(bitset.FindFirstBitClear() == used);
+    REQUIRE(summary.FindFirstBitClear() == used);
+
+    // Bitset::FindFirstRangeClear() logs every step when testing, so
+    // only the single bit scan is compared against the original
+    BENCHMARK("Bitset::FindFirstBitClear " + std::to_string(occupancy) + "%") {
+        return bitset.FindFirstBitClear();
+    };
+    BENCHMARK("SummaryBitset::FindFirstBitClear " + std::to_string(occupancy) + "%") {
+        return summary.FindFirstBitClear();
+    };
+    BENCHMARK("SummaryBitset::FindFirstRangeClear(64) " + std::to_string(occupancy) + "%") {
+        return summary.FindFirstRangeClear(64);
+    };
+}
@@ -10,6 +10,8 @@
  */
 // Let Catch provide main():
 #define CATCH_CONFIG_MAIN
+// Allow BENCHMARK() to be used in hidden benchmark test cases
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 // Include Catch2 single header
 #include <catch2/catch.hpp>
 // Function prototypes
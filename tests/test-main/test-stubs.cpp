@@ -0,0 +1,117 @@
+/**
+ * @file test-stubs.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Host stand-ins for kernel services used by the code under test
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <mem/paging.hpp>
+#include <mem/frames.hpp>
+#include <mem/memstats.hpp>
+#include <lib/mutex.hpp>
+#include <dev/serial/rs232.hpp>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+// Pages come from the host heap, aligned just like the real thing
+void* get_new_page(uint32_t size) {
+    return aligned_alloc(PAGE_SIZE, ((size / PAGE_SIZE) + 1) * PAGE_SIZE);
+}
+
+void free_page(void *page, uint32_t size) {
+    (void)size;
+    free(page);
+}
+
+// Host pages have no frames, so there are no descriptors to tag either
+size_t page_frame(void *addr) {
+    (void)addr;
+    return SIZE_MAX;
+}
+
+void frame_set_flags(size_t frame, uint8_t flags) {
+    (void)frame;
+    (void)flags;
+}
+
+void frame_clear_flags(size_t frame, uint8_t flags) {
+    (void)frame;
+    (void)flags;
+}
+
+// A handful of frames for code that hands out frame numbers, with the
+// physical address of a frame being its offset into the array
+#define TEST_FRAMES 128
+alignas(PAGE_SIZE) static uint8_t test_frames[TEST_FRAMES][PAGE_SIZE];
+static bool test_frames_used[TEST_FRAMES];
+
+size_t frames_alloc() {
+    for (size_t i = 0; i < TEST_FRAMES; i++) {
+        if (!test_frames_used[i]) {
+            test_frames_used[i] = true;
+            return i;
+        }
+    }
+    return SIZE_MAX;
+}
+
+void frames_free(size_t frame) {
+    test_frames_used[frame] = false;
+}
+
+void *kmap_temp(phys_addr_t paddr) {
+    return &test_frames[0][0] + paddr;
+}
+
+void kunmap_temp(void *addr) {
+    (void)addr;
+}
+
+// Page accounting done by the code under test
+size_t mem_owner_pages[MEM_OWNERS];
+
+// Unit tests are single threaded so locks never contend
+mutex::mutex(const char *name)
+    : locked(false)
+{
+    task_sync.dbg_name = name;
+}
+
+int mutex_init(mutex_t *mutex) {
+    mutex->locked = false;
+    return 0;
+}
+
+int mutex_lock(mutex_t *mutex) {
+    mutex->locked = true;
+    return 0;
+}
+
+int mutex_trylock(mutex_t *mutex) {
+    if (mutex->locked) {
+        return -1;
+    }
+    mutex->locked = true;
+    return 0;
+}
+
+int mutex_unlock(mutex_t *mutex) {
+    mutex->locked = false;
+    return 0;
+}
+
+namespace rs232 {
+
+int printf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int ret = ::vprintf(format, args);
+    va_end(args);
+    return ret;
+}
+
+}
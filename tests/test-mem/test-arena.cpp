@@ -0,0 +1,116 @@
+/**
+ * @file test-arena.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Arena allocator unit tests
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <mem/arena.cpp>
+#include <string.h>
+
+TEST_CASE("arena allocations", "[arena]") {
+    arena_t arena;
+    arena_init(&arena, "test");
+    size_t pages = mem_owner_pages[MEM_OWNER_ARENAS];
+
+    SECTION("allocations are aligned and do not overlap") {
+        uint8_t *a = (uint8_t *)arena_alloc(&arena, 3);
+        uint8_t *b = (uint8_t *)arena_alloc(&arena, 16, 16);
+        uint8_t *c = (uint8_t *)arena_alloc(&arena, 1, 1);
+        REQUIRE(a != NULL);
+        REQUIRE((uintptr_t)a % ARENA_ALIGN == 0);
+        REQUIRE((uintptr_t)b % 16 == 0);
+        REQUIRE(b >= a + 3);
+        REQUIRE(c == b + 16);
+        REQUIRE(mem_owner_pages[MEM_OWNER_ARENAS] == pages + ARENA_CHUNK_SIZE / PAGE_SIZE);
+    }
+    SECTION("a reset frees everything after the mark") {
+        void *keep = arena_alloc(&arena, 64);
+        arena_mark_t mark = arena_mark(&arena);
+        void *first = arena_alloc(&arena, 100);
+        // spill over into more chunks
+        for (size_t i = 0; i < 8; i++) {
+            REQUIRE(arena_alloc(&arena, ARENA_CHUNK_SIZE / 2) != NULL);
+        }
+        size_t grown = mem_owner_pages[MEM_OWNER_ARENAS];
+        arena_reset(&arena, mark);
+        REQUIRE(arena_alloc(&arena, 100) == first);
+        // chunks are reused rather than allocated again
+        for (size_t i = 0; i < 8; i++) {
+            REQUIRE(arena_alloc(&arena, ARENA_CHUNK_SIZE / 2) != NULL);
+        }
+        REQUIRE(mem_owner_pages[MEM_OWNER_ARENAS] == grown);
+        arena_reset(&arena, mark);
+        REQUIRE(arena_trim(&arena) > 0);
+        REQUIRE(mem_owner_pages[MEM_OWNER_ARENAS] == pages + ARENA_CHUNK_SIZE / PAGE_SIZE);
+        REQUIRE(arena_alloc(&arena, 0) != keep);
+    }
+    SECTION("large allocations get a chunk of their own") {
+        uint8_t *big = (uint8_t *)arena_alloc(&arena, 5 * ARENA_CHUNK_SIZE);
+        REQUIRE(big != NULL);
+        memset(big, 0x5A, 5 * ARENA_CHUNK_SIZE);
+        REQUIRE(arena_alloc(&arena, SIZE_MAX) == NULL);
+    }
+    SECTION("scopes release on exit") {
+        arena_mark_t before = arena_mark(&arena);
+        void *inner;
+        {
+            ArenaScope scope(&arena);
+            inner = scope.Alloc(32);
+            REQUIRE(inner != NULL);
+        }
+        REQUIRE(arena_alloc(&arena, 32) == inner);
+        (void)before;
+    }
+    arena_release(&arena);
+    REQUIRE(mem_owner_pages[MEM_OWNER_ARENAS] == pages);
+}
+
+TEST_CASE("fixed arenas never grow", "[arena]") {
+    alignas(ARENA_ALIGN) static uint8_t buf[256];
+    arena_t arena;
+    arena_init_fixed(&arena, "fixed", buf, sizeof(buf));
+    void *a = arena_alloc(&arena, 128);
+    REQUIRE(a >= (void *)buf);
+    REQUIRE(a < (void *)(buf + sizeof(buf)));
+    REQUIRE(arena_alloc(&arena, 256) == NULL);
+    {
+        ArenaScope scope(&arena);
+        REQUIRE(scope.Alloc(64) != NULL);
+        REQUIRE(scope.Alloc(128) == NULL);
+    }
+    arena_release(&arena);
+    REQUIRE(arena_alloc(&arena, 128) == a);
+}
+
+// Hidden by default, run with: unit-test "[benchmark]"
+TEST_CASE("arena allocation benchmark", "[.][benchmark][arena]") {
+    arena_t arena;
+    arena_init(&arena, "bench");
+    BENCHMARK("arena scope with 16 temporaries") {
+        ArenaScope scope(&arena);
+        uintptr_t sum = 0;
+        for (size_t i = 0; i < 16; i++) {
+            sum += (uintptr_t)scope.Alloc(64 + i * 8);
+        }
+        return sum;
+    };
+    BENCHMARK("malloc/free of 16 temporaries") {
+        void *ptrs[16];
+        uintptr_t sum = 0;
+        for (size_t i = 0; i < 16; i++) {
+            ptrs[i] = malloc(64 + i * 8);
+            sum += (uintptr_t)ptrs[i];
+        }
+        for (size_t i = 0; i < 16; i++) {
+            free(ptrs[i]);
+        }
+        return sum;
+    };
+    arena_release(&arena);
+}
@@ -0,0 +1,88 @@
+/**
+ * @file test-buddy.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Buddy allocator unit tests
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <catch2/catch.hpp>
+#include <mem/buddy.cpp>
+
+#define TEST_BUDDY_FRAMES 4096
+static uint8_t buddyMetadata[TEST_BUDDY_FRAMES * 9];
+
+TEST_CASE("buddy allocator operations", "[buddy]") {
+    REQUIRE(BuddyAllocator::MetadataSize(TEST_BUDDY_FRAMES) <= sizeof(buddyMetadata));
+    BuddyAllocator buddy = BuddyAllocator(buddyMetadata, TEST_BUDDY_FRAMES);
+    REQUIRE(buddy.FreeFrames() == 0);
+
+    SECTION("regions are coalesced into maximal blocks") {
+        buddy.AddRegion(0, TEST_BUDDY_FRAMES);
+        REQUIRE(buddy.FreeFrames() == TEST_BUDDY_FRAMES);
+        REQUIRE(buddy.FreeBlocks(BUDDY_MAX_ORDER) == TEST_BUDDY_FRAMES >> BUDDY_MAX_ORDER);
+        for (size_t order = 0; order < BUDDY_MAX_ORDER; order++) {
+            REQUIRE(buddy.FreeBlocks(order) == 0);
+        }
+    }
+    SECTION("unaligned regions") {
+        buddy.AddRegion(3, 1030);
+        REQUIRE(buddy.FreeFrames() == 1030);
+        // Frames outside of the region are never handed out
+        for (size_t i = 0; i < 1030; i++) {
+            size_t frame = buddy.Alloc(0);
+            REQUIRE(frame >= 3);
+            REQUIRE(frame < 1033);
+        }
+        REQUIRE(buddy.Alloc(0) == SIZE_MAX);
+    }
+    SECTION("split and coalesce") {
+        buddy.AddRegion(0, 1 << BUDDY_MAX_ORDER);
+        size_t a = buddy.Alloc(0);
+        size_t b = buddy.Alloc(0);
+        REQUIRE(a != SIZE_MAX);
+        REQUIRE(b != SIZE_MAX);
+        REQUIRE(a != b);
+        // One block of every order below the maximum is left over after the split
+        REQUIRE(buddy.FreeFrames() == (1 << BUDDY_MAX_ORDER) - 2);
+        REQUIRE(buddy.FreeBlocks(BUDDY_MAX_ORDER) == 0);
+        buddy.Free(a, 0);
+        buddy.Free(b, 0);
+        REQUIRE(buddy.FreeBlocks(BUDDY_MAX_ORDER) == 1);
+        REQUIRE(buddy.FreeFrames() == 1 << BUDDY_MAX_ORDER);
+    }
+    SECTION("blocks are naturally aligned") {
+        buddy.AddRegion(0, TEST_BUDDY_FRAMES);
+        for (size_t order = 0; order <= BUDDY_MAX_ORDER; order++) {
+            size_t frame = buddy.Alloc(order);
+            REQUIRE(frame != SIZE_MAX);
+            REQUIRE((frame & ((1 << order) - 1)) == 0);
+        }
+    }
+    SECTION("contiguous runs") {
+        buddy.AddRegion(0, TEST_BUDDY_FRAMES);
+        size_t run = buddy.AllocContiguous(5);
+        REQUIRE(run != SIZE_MAX);
+        REQUIRE(buddy.FreeFrames() == TEST_BUDDY_FRAMES - 5);
+        // The tail of the 8 frame block goes straight back
+        size_t tail = buddy.Alloc(0);
+        REQUIRE(tail == run + 5);
+        buddy.Free(tail, 0);
+        buddy.FreeContiguous(run, 5);
+        REQUIRE(buddy.FreeFrames() == TEST_BUDDY_FRAMES);
+        REQUIRE(buddy.FreeBlocks(BUDDY_MAX_ORDER) == TEST_BUDDY_FRAMES >> BUDDY_MAX_ORDER);
+        // Runs larger than the biggest block are refused
+        REQUIRE(buddy.AllocContiguous((1 << BUDDY_MAX_ORDER) + 1) == SIZE_MAX);
+        REQUIRE(buddy.AllocContiguous(0) == SIZE_MAX);
+    }
+    SECTION("exhaustion") {
+        buddy.AddRegion(0, TEST_BUDDY_FRAMES);
+        for (size_t i = 0; i < TEST_BUDDY_FRAMES >> BUDDY_MAX_ORDER; i++) {
+            REQUIRE(buddy.Alloc(BUDDY_MAX_ORDER) != SIZE_MAX);
+        }
+        REQUIRE(buddy.Alloc(0) == SIZE_MAX);
+        REQUIRE(buddy.FreeFrames() == 0);
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ * @file test-heap-profile.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Heap profiler unit tests
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <catch2/catch.hpp>
+#include <mem/heap_profile.cpp>
+
+volatile uint32_t timer_tick;
+
+#define SITE_A ((void *)0x1000)
+#define SITE_B ((void *)0x2000)
+
+TEST_CASE("heap profiler", "[heap_profile]") {
+    REQUIRE_FALSE(heap_profile_active);
+    // nothing is recorded while it is off
+    heap_profile_alloc((void *)0x100, 8, SITE_A);
+    REQUIRE(heap_profile_start());
+    REQUIRE(heap_profile_active);
+    heap_site_t top[4];
+
+    SECTION("sites are ranked by live bytes") {
+        heap_profile_alloc((void *)0x10000, 16, SITE_A);
+        heap_profile_alloc((void *)0x10010, 16, SITE_A);
+        heap_profile_alloc((void *)0x20000, 4096, SITE_B);
+        REQUIRE(heap_profile_top(top, 4) == 2);
+        REQUIRE(top[0].caller == (uintptr_t)SITE_B);
+        REQUIRE(top[0].live_bytes == 4096);
+        REQUIRE(top[0].classes[8] == 1);
+        REQUIRE(top[1].caller == (uintptr_t)SITE_A);
+        REQUIRE(top[1].classes[0] == 2);
+        heap_profile_free((void *)0x20000);
+        REQUIRE(heap_profile_top(top, 1) == 1);
+        REQUIRE(top[0].caller == (uintptr_t)SITE_A);
+        REQUIRE(heap_profile_top(top, 4) == 2);
+        REQUIRE(top[1].live_bytes == 0);
+        REQUIRE(top[1].peak_bytes == 4096);
+        REQUIRE(top[1].frees == 1);
+        heap_profile_print();
+    }
+    SECTION("frees of unknown memory are ignored") {
+        heap_profile_free((void *)0x100);
+        heap_profile_alloc((void *)0x100, 8, SITE_A);
+        REQUIRE(heap_profile_top(top, 4) == 1);
+        REQUIRE(top[0].frees == 0);
+        REQUIRE(top[0].live_bytes == 8);
+    }
+    SECTION("many live allocations keep their sites") {
+        // collide in the live table and remove in an unrelated order
+        for (uintptr_t i = 1; i <= 4096; i++) {
+            heap_profile_alloc((void *)(i * 16), 24, (i & 1) ? SITE_A : SITE_B);
+        }
+        for (uintptr_t i = 1; i <= 4096; i += 3) {
+            heap_profile_free((void *)(i * 16));
+        }
+        size_t live_a = 0, live_b = 0;
+        for (uintptr_t i = 1; i <= 4096; i++) {
+            if ((i - 1) % 3 == 0) continue;
+            ((i & 1) ? live_a : live_b) += 24;
+        }
+        REQUIRE(heap_profile_top(top, 4) == 2);
+        size_t got_a = top[0].caller == (uintptr_t)SITE_A ? top[0].live_bytes : top[1].live_bytes;
+        size_t got_b = top[0].caller == (uintptr_t)SITE_B ? top[0].live_bytes : top[1].live_bytes;
+        REQUIRE(got_a == live_a);
+        REQUIRE(got_b == live_b);
+    }
+    SECTION("a full site table folds into one entry") {
+        for (uintptr_t i = 1; i <= HEAP_PROFILE_SITES * 2; i++) {
+            heap_profile_alloc((void *)(i * 16), 8, (void *)(i * 4));
+        }
+        heap_site_t all[HEAP_PROFILE_SITES];
+        size_t count = heap_profile_top(all, HEAP_PROFILE_SITES);
+        REQUIRE(count == HEAP_PROFILE_SITES);
+        size_t allocs = 0;
+        for (size_t i = 0; i < count; i++) allocs += all[i].allocs;
+        REQUIRE(allocs == HEAP_PROFILE_SITES * 2);
+    }
+    heap_profile_stop();
+    REQUIRE_FALSE(heap_profile_active);
+    REQUIRE(heap_profile_top(top, 4) == 0);
+}
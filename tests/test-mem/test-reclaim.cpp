@@ -0,0 +1,128 @@
+/**
+ * @file test-reclaim.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Shrinker registry unit tests
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <catch2/catch.hpp>
+#include <mem/reclaim.cpp>
+
+// The frame allocator is not part of the unit tests
+static size_t test_usable_frames = 0;
+
+void frames_get_stats(frames_stats_t *stats) {
+    stats->usable = test_usable_frames;
+    stats->free = 0;
+    stats->reserved = 0;
+    stats->largest_free = 0;
+    stats->high_free = 0;
+}
+
+size_t frames_free_count() {
+    return 0;
+}
+
+void tasks_nano_sleep(uint64_t time) {
+    (void)time;
+}
+
+static size_t test_pages[2];
+static size_t test_order[4];
+static size_t test_calls = 0;
+
+static size_t test_count_first(void) { return test_pages[0]; }
+static size_t test_count_second(void) { return test_pages[1]; }
+
+static size_t test_scan(size_t idx, size_t pages)
+{
+    test_order[test_calls++ % 4] = idx;
+    size_t freed = pages < test_pages[idx] ? pages : test_pages[idx];
+    test_pages[idx] -= freed;
+    return freed;
+}
+
+static size_t test_scan_first(size_t pages) { return test_scan(0, pages); }
+static size_t test_scan_second(size_t pages) { return test_scan(1, pages); }
+
+TEST_CASE("shrinker registry", "[reclaim]") {
+    shrinker_t first = { "first", test_count_first, test_scan_first, NULL };
+    shrinker_t second = { "second", test_count_second, test_scan_second, NULL };
+    shrinker_register(&first);
+    shrinker_register(&second);
+    reclaim_stats_t before;
+    reclaim_get_stats(&before);
+
+    SECTION("shrinkers are asked in order until enough is freed") {
+        test_pages[0] = 3;
+        test_pages[1] = 10;
+        test_calls = 0;
+        REQUIRE(reclaim_pages(5) == 5);
+        REQUIRE(test_calls == 2);
+        REQUIRE(test_order[0] == 0);
+        REQUIRE(test_order[1] == 1);
+        REQUIRE(test_pages[0] == 0);
+        REQUIRE(test_pages[1] == 8);
+        // the first one is empty now and is not asked again
+        test_calls = 0;
+        REQUIRE(reclaim_pages(2) == 2);
+        REQUIRE(test_calls == 1);
+        REQUIRE(test_order[0] == 1);
+        reclaim_stats_t after;
+        reclaim_get_stats(&after);
+        REQUIRE(after.runs == before.runs + 2);
+        REQUIRE(after.reclaimed == before.reclaimed + 7);
+    }
+    SECTION("running out of memory to give back") {
+        test_pages[0] = 1;
+        test_pages[1] = 1;
+        REQUIRE(reclaim_pages(100) == 2);
+        REQUIRE(reclaim_pages(100) == 0);
+    }
+    SECTION("allocations do not wait for a pass in progress") {
+        test_pages[0] = 4;
+        test_pages[1] = 0;
+        mutex_lock(&mutex_shrinkers);
+        REQUIRE(reclaim_pages(4) == 0);
+        mutex_unlock(&mutex_shrinkers);
+        REQUIRE(test_pages[0] == 4);
+        REQUIRE(reclaim_pages(4) == 4);
+    }
+    SECTION("unregistered shrinkers are left alone") {
+        shrinker_unregister(&first);
+        test_pages[0] = 4;
+        test_pages[1] = 4;
+        REQUIRE(reclaim_pages(8) == 4);
+        REQUIRE(test_pages[0] == 4);
+    }
+
+    shrinker_unregister(&first);
+    shrinker_unregister(&second);
+    REQUIRE(shrinkers == NULL);
+}
+
+TEST_CASE("reclaim watermarks", "[reclaim]") {
+    // Small machines get the floor
+    test_usable_frames = 1024;
+    reclaim_init();
+    reclaim_stats_t stats;
+    reclaim_get_stats(&stats);
+    REQUIRE(stats.low == RECLAIM_LOW_MIN);
+    REQUIRE(stats.high == RECLAIM_LOW_MIN * RECLAIM_HIGH_FACTOR);
+    shrinker_unregister(&zero_pool_shrinker);
+    shrinker_unregister(&slab_shrinker);
+
+    test_usable_frames = 1024 * 1024;
+    reclaim_init();
+    reclaim_get_stats(&stats);
+    REQUIRE(stats.low == 1024 * 1024 / RECLAIM_LOW_DIVISOR);
+    REQUIRE(stats.high == stats.low * RECLAIM_HIGH_FACTOR);
+    // The kernel's own caches are registered, cheapest first
+    REQUIRE(shrinkers == &zero_pool_shrinker);
+    REQUIRE(shrinkers->next == &slab_shrinker);
+    shrinker_unregister(&zero_pool_shrinker);
+    shrinker_unregister(&slab_shrinker);
+}
@@ -0,0 +1,171 @@
+/**
+ * @file test-slab.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Slab allocator unit tests
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <mem/slab.cpp>
+#include <lib/LinkedList.hpp>
+#include <string.h>
+
+typedef struct test_object {
+    uint32_t magic;
+    uint8_t payload[44];
+} test_object_t;
+
+#define TEST_OBJECT_MAGIC 0xC0FFEE
+static size_t constructed = 0;
+
+static void test_object_ctor(void *obj)
+{
+    ((test_object_t *)obj)->magic = TEST_OBJECT_MAGIC;
+    constructed++;
+}
+
+TEST_CASE("slab cache operations", "[slab]") {
+    kmem_cache_t *cache = kmem_cache_create("test_object", sizeof(test_object_t), 0, test_object_ctor);
+    REQUIRE(cache != NULL);
+    REQUIRE(cache->per_slab > 1);
+    REQUIRE(cache->size % sizeof(void *) == 0);
+
+    SECTION("invalid caches are refused") {
+        REQUIRE(kmem_cache_create("zero", 0, 0, NULL) == NULL);
+        REQUIRE(kmem_cache_create("huge", KMEM_MAX_OBJECT + 1, 0, NULL) == NULL);
+        REQUIRE(kmem_cache_create("odd", 16, 3, NULL) == NULL);
+    }
+    SECTION("objects are constructed once per slab") {
+        constructed = 0;
+        test_object_t *obj = (test_object_t *)kmem_cache_alloc(cache);
+        REQUIRE(obj != NULL);
+        REQUIRE(obj->magic == TEST_OBJECT_MAGIC);
+        REQUIRE(constructed == cache->per_slab);
+        kmem_cache_free(cache, obj);
+        obj = (test_object_t *)kmem_cache_alloc(cache);
+        REQUIRE(constructed == cache->per_slab);
+        kmem_cache_free(cache, obj);
+    }
+    SECTION("slabs fill up and drain") {
+        size_t count = cache->per_slab * 3 + 1;
+        test_object_t **objs = new test_object_t*[count];
+        for (size_t i = 0; i < count; i++) {
+            objs[i] = (test_object_t *)kmem_cache_alloc(cache);
+            REQUIRE(objs[i] != NULL);
+            REQUIRE(((uintptr_t)objs[i] & (cache->align - 1)) == 0);
+            for (size_t j = 0; j < i; j++) {
+                REQUIRE(objs[i] != objs[j]);
+            }
+        }
+        REQUIRE(cache->stats.slabs == 4);
+        REQUIRE(cache->stats.active == count);
+        REQUIRE(cache->stats.total == cache->per_slab * 4);
+        for (size_t i = 0; i < count; i++) {
+            kmem_cache_free(cache, objs[i]);
+        }
+        // A single empty slab is kept around
+        REQUIRE(cache->stats.slabs == 1);
+        REQUIRE(cache->stats.active == 0);
+        REQUIRE(cache->stats.allocs == cache->stats.frees);
+        delete[] objs;
+    }
+    SECTION("empty slabs are reaped") {
+        test_object_t *obj = (test_object_t *)kmem_cache_alloc(cache);
+        kmem_cache_free(cache, obj);
+        REQUIRE(cache->empty != NULL);
+        REQUIRE(kmem_cache_reclaimable() >= 1);
+        // Busy caches are skipped rather than waited for
+        mutex_lock(&cache->lock);
+        kmem_cache_reap(SIZE_MAX);
+        mutex_unlock(&cache->lock);
+        REQUIRE(cache->empty != NULL);
+        size_t reaped = kmem_cache_reap(SIZE_MAX);
+        REQUIRE(reaped >= 1);
+        REQUIRE(cache->empty == NULL);
+        REQUIRE(cache->stats.slabs == 0);
+        // ...and the cache keeps working afterwards
+        obj = (test_object_t *)kmem_cache_alloc(cache);
+        REQUIRE(obj != NULL);
+        REQUIRE(obj->magic == TEST_OBJECT_MAGIC);
+        kmem_cache_free(cache, obj);
+    }
+    SECTION("slabs are coloured") {
+        size_t count = cache->per_slab * 2;
+        test_object_t **objs = new test_object_t*[count];
+        for (size_t i = 0; i < count; i++) {
+            objs[i] = (test_object_t *)kmem_cache_alloc(cache);
+        }
+        if (cache->colours > 1) {
+            // The first object of each slab starts a cache line further along
+            uintptr_t first = (uintptr_t)objs[0] % PAGE_SIZE;
+            uintptr_t second = (uintptr_t)objs[cache->per_slab] % PAGE_SIZE;
+            REQUIRE(second == first + KMEM_CACHE_LINE);
+        }
+        for (size_t i = 0; i < count; i++) {
+            kmem_cache_free(cache, objs[i]);
+        }
+        delete[] objs;
+    }
+}
+
+// Hidden by default, run with: unit-test "[benchmark]"
+static kmem_cache_t *test_find_cache(const char *name)
+{
+    for (kmem_cache_t *cache = caches; cache != NULL; cache = cache->next) {
+        if (strcmp(cache->name, name) == 0) return cache;
+    }
+    return NULL;
+}
+
+TEST_CASE("list nodes get a cache per type", "[slab]") {
+    LinkedList::LinkedListNode<uint16_t> *small = new LinkedList::LinkedListNode<uint16_t>(1);
+    LinkedList::LinkedListNode<test_object_t *> *ptr = new LinkedList::LinkedListNode<test_object_t *>(NULL);
+    REQUIRE(small != NULL);
+    REQUIRE(ptr != NULL);
+    kmem_cache_t *small_cache = test_find_cache("list_node<short unsigned int>");
+    kmem_cache_t *ptr_cache = test_find_cache("list_node<test_object*>");
+    REQUIRE(small_cache != NULL);
+    REQUIRE(ptr_cache != NULL);
+    REQUIRE(small_cache != ptr_cache);
+    REQUIRE(small_cache->stats.active == 1);
+    delete small;
+    delete ptr;
+    REQUIRE(small_cache->stats.active == 0);
+    REQUIRE(ptr_cache->stats.active == 0);
+}
+
+TEST_CASE("slab allocation benchmark", "[.][benchmark][slab]") {
+    kmem_cache_t *cache = kmem_cache_create("bench_object", sizeof(test_object_t), 0, NULL);
+    REQUIRE(cache != NULL);
+    // Compared against the host's malloc since liballoc is not built for the host
+    BENCHMARK("kmem_cache_alloc/free") {
+        void *obj = kmem_cache_alloc(cache);
+        uintptr_t addr = (uintptr_t)obj;
+        kmem_cache_free(cache, obj);
+        return addr;
+    };
+    BENCHMARK("malloc/free") {
+        void *obj = malloc(sizeof(test_object_t));
+        uintptr_t addr = (uintptr_t)obj;
+        free(obj);
+        return addr;
+    };
+    BENCHMARK("kmem_cache_alloc/free x64") {
+        void *objs[64];
+        for (size_t i = 0; i < 64; i++) objs[i] = kmem_cache_alloc(cache);
+        uintptr_t addr = (uintptr_t)objs[0];
+        for (size_t i = 0; i < 64; i++) kmem_cache_free(cache, objs[i]);
+        return addr;
+    };
+    BENCHMARK("malloc/free x64") {
+        void *objs[64];
+        for (size_t i = 0; i < 64; i++) objs[i] = malloc(sizeof(test_object_t));
+        uintptr_t addr = (uintptr_t)objs[0];
+        for (size_t i = 0; i < 64; i++) free(objs[i]);
+        return addr;
+    };
+}
@@ -0,0 +1,174 @@
+/**
+ * @file test-tlsf.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief TLSF allocator unit tests
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <mem/tlsf.cpp>
+#include <string.h>
+#include <vector>
+#include <random>
+
+#define TEST_POOL_SIZE (1024 * 1024)
+
+TEST_CASE("tlsf heap operations", "[tlsf]") {
+    void *mem = aligned_alloc(4096, TEST_POOL_SIZE);
+    TlsfHeap *heap = new TlsfHeap();
+    REQUIRE(heap->AddPool(mem, TEST_POOL_SIZE));
+    size_t initial = heap->FreeSize();
+    REQUIRE(initial == TEST_POOL_SIZE - TlsfHeap::PoolOverhead());
+    REQUIRE(heap->FreeBlocks() == 1);
+    REQUIRE(heap->LargestFree() == initial);
+
+    SECTION("invalid requests are refused") {
+        REQUIRE(heap->Alloc(0) == NULL);
+        REQUIRE(heap->Alloc(TEST_POOL_SIZE) == NULL);
+        REQUIRE_FALSE(heap->AddPool((uint8_t *)mem + 1, 64));
+        REQUIRE_FALSE(heap->AddPool(mem, TlsfHeap::PoolOverhead()));
+    }
+    SECTION("allocations are aligned and distinct") {
+        void *ptrs[64];
+        for (size_t i = 0; i < 64; i++) {
+            ptrs[i] = heap->Alloc(i + 1);
+            REQUIRE(ptrs[i] != NULL);
+            REQUIRE((uintptr_t)ptrs[i] % TLSF_ALIGN_SIZE == 0);
+            REQUIRE(heap->BlockSize(ptrs[i]) >= i + 1);
+            memset(ptrs[i], (int)i, i + 1);
+        }
+        for (size_t i = 0; i < 64; i++) {
+            for (size_t j = 0; j <= i; j++) {
+                REQUIRE(((uint8_t *)ptrs[i])[j] == (uint8_t)i);
+            }
+            heap->Free(ptrs[i]);
+        }
+        // Everything coalesces back into the original block
+        REQUIRE(heap->FreeBlocks() == 1);
+        REQUIRE(heap->FreeSize() == initial);
+    }
+    SECTION("neighbours coalesce in any order") {
+        void *a = heap->Alloc(256);
+        void *b = heap->Alloc(256);
+        void *c = heap->Alloc(256);
+        heap->Free(a);
+        heap->Free(c);
+        REQUIRE(heap->FreeBlocks() == 2);
+        heap->Free(b);
+        REQUIRE(heap->FreeBlocks() == 1);
+        REQUIRE(heap->FreeSize() == initial);
+    }
+    SECTION("realloc grows in place when the next block is free") {
+        uint8_t *a = (uint8_t *)heap->Alloc(64);
+        memset(a, 0xAB, 64);
+        uint8_t *b = (uint8_t *)heap->Realloc(a, 4096);
+        REQUIRE(b == a);
+        REQUIRE(heap->BlockSize(b) >= 4096);
+        // Shrinking hands the tail back
+        REQUIRE(heap->Realloc(b, 32) == b);
+        REQUIRE(heap->BlockSize(b) < 64);
+        REQUIRE(b[31] == 0xAB);
+        heap->Free(b);
+        REQUIRE(heap->FreeSize() == initial);
+    }
+    SECTION("realloc moves when the next block is used") {
+        uint8_t *a = (uint8_t *)heap->Alloc(64);
+        void *guard = heap->Alloc(64);
+        for (size_t i = 0; i < 64; i++) a[i] = (uint8_t)i;
+        // Resizing in place is refused, and nothing changes
+        REQUIRE(!heap->Resize(a, 1024));
+        REQUIRE(heap->BlockSize(a) < 1024);
+        uint8_t *b = (uint8_t *)heap->Realloc(a, 1024);
+        REQUIRE(b != NULL);
+        REQUIRE(b != a);
+        for (size_t i = 0; i < 64; i++) REQUIRE(b[i] == (uint8_t)i);
+        heap->Free(b);
+        heap->Free(guard);
+        REQUIRE(heap->FreeBlocks() == 1);
+    }
+    SECTION("pools can be added later") {
+        // Good fit rounds requests up a size class, so fill the pool instead
+        // of asking for exactly the size of the free block
+        std::vector<void *> fill;
+        for (void *ptr; (ptr = heap->Alloc(16)) != NULL;) {
+            fill.push_back(ptr);
+        }
+        void *more = aligned_alloc(4096, 4096);
+        REQUIRE(heap->AddPool(more, 4096));
+        void *small = heap->Alloc(16);
+        REQUIRE(small >= more);
+        REQUIRE(small < (uint8_t *)more + 4096);
+        heap->Free(small);
+        for (void *ptr : fill) {
+            heap->Free(ptr);
+        }
+        REQUIRE(heap->FreeSize() == initial + 4096 - TlsfHeap::PoolOverhead());
+        free(more);
+    }
+    SECTION("random allocations match a model") {
+        std::mt19937 rng(1234);
+        std::vector<std::pair<uint8_t *, size_t>> live;
+        for (size_t iter = 0; iter < 20000; iter++) {
+            if (live.empty() || rng() % 3 != 0) {
+                size_t size = (rng() % 8 == 0) ? rng() % 16384 + 1 : rng() % 256 + 1;
+                uint8_t *ptr = (uint8_t *)heap->Alloc(size);
+                if (ptr == NULL) {
+                    REQUIRE(heap->LargestFree() < size + TLSF_SMALL_BLOCK_SIZE * 64);
+                    continue;
+                }
+                memset(ptr, (int)(size & 0xFF), size);
+                live.push_back({ ptr, size });
+            } else {
+                size_t idx = rng() % live.size();
+                uint8_t *ptr = live[idx].first;
+                size_t size = live[idx].second;
+                REQUIRE(ptr[0] == (uint8_t)(size & 0xFF));
+                REQUIRE(ptr[size - 1] == (uint8_t)(size & 0xFF));
+                heap->Free(ptr);
+                live[idx] = live.back();
+                live.pop_back();
+            }
+        }
+        for (auto &block : live) {
+            heap->Free(block.first);
+        }
+        REQUIRE(heap->FreeBlocks() == 1);
+        REQUIRE(heap->FreeSize() == initial);
+    }
+    delete heap;
+    free(mem);
+}
+
+// Hidden by default, run with: unit-test "[benchmark]"
+TEST_CASE("tlsf allocation benchmark", "[.][benchmark][tlsf]") {
+    void *mem = aligned_alloc(4096, 16 * TEST_POOL_SIZE);
+    TlsfHeap *heap = new TlsfHeap();
+    REQUIRE(heap->AddPool(mem, 16 * TEST_POOL_SIZE));
+    // Fragment the heap so that the free lists are not trivially short
+    std::mt19937 rng(42);
+    std::vector<void *> keep;
+    for (size_t i = 0; i < 4096; i++) {
+        void *ptr = heap->Alloc(rng() % 2048 + 1);
+        if (i % 2) heap->Free(ptr);
+        else keep.push_back(ptr);
+    }
+    BENCHMARK("TlsfHeap::Alloc/Free (fragmented)") {
+        void *ptr = heap->Alloc(rng() % 2048 + 1);
+        uintptr_t addr = (uintptr_t)ptr;
+        heap->Free(ptr);
+        return addr;
+    };
+    BENCHMARK("malloc/free") {
+        void *ptr = malloc(rng() % 2048 + 1);
+        uintptr_t addr = (uintptr_t)ptr;
+        free(ptr);
+        return addr;
+    };
+    for (void *ptr : keep) heap->Free(ptr);
+    delete heap;
+    free(mem);
+}
@@ -0,0 +1,129 @@
+/**
+ * @file test-vmem.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Virtual address arena unit tests
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <catch2/catch.hpp>
+#include <mem/vmem.cpp>
+
+#define TEST_VMEM_QUANTUM   0x1000
+#define TEST_VMEM_BASE      0x10000000
+#define TEST_VMEM_SIZE      0x1000000
+#define TEST_VMEM_SEGMENTS  256
+static vmem_segment_t vmemSegments[TEST_VMEM_SEGMENTS];
+
+TEST_CASE("vmem arena operations", "[vmem]") {
+    VmemArena arena = VmemArena(TEST_VMEM_QUANTUM);
+    arena.AddSegments(vmemSegments, sizeof(vmemSegments));
+    REQUIRE(arena.SpareSegments() == TEST_VMEM_SEGMENTS);
+    arena.Add(TEST_VMEM_BASE, TEST_VMEM_SIZE);
+    REQUIRE(arena.FreeSize() == TEST_VMEM_SIZE);
+    REQUIRE(arena.FreeSegments() == 1);
+
+    SECTION("allocations are rounded to the quantum") {
+        uintptr_t a = arena.Alloc(1, 1);
+        uintptr_t b = arena.Alloc(TEST_VMEM_QUANTUM + 1, 1);
+        REQUIRE(a == TEST_VMEM_BASE);
+        REQUIRE(b == TEST_VMEM_BASE + TEST_VMEM_QUANTUM);
+        REQUIRE(arena.FreeSize() == TEST_VMEM_SIZE - 3 * TEST_VMEM_QUANTUM);
+        REQUIRE(arena.Alloc(0, 1) == VMEM_FAILED);
+    }
+    SECTION("ranges larger than a word of pages") {
+        // The old bitmap scan could not find more than 32 pages in a row
+        uintptr_t a = arena.Alloc(100 * TEST_VMEM_QUANTUM, TEST_VMEM_QUANTUM);
+        uintptr_t b = arena.Alloc(1000 * TEST_VMEM_QUANTUM, TEST_VMEM_QUANTUM);
+        REQUIRE(a != VMEM_FAILED);
+        REQUIRE(b == a + 100 * TEST_VMEM_QUANTUM);
+        REQUIRE(arena.Alloc(TEST_VMEM_SIZE, TEST_VMEM_QUANTUM) == VMEM_FAILED);
+    }
+    SECTION("alignment") {
+        arena.Alloc(TEST_VMEM_QUANTUM, 1);
+        uintptr_t a = arena.Alloc(TEST_VMEM_QUANTUM, 0x100000);
+        REQUIRE(a != VMEM_FAILED);
+        REQUIRE((a & 0xFFFFF) == 0);
+        // The gap in front of the aligned range stays available
+        REQUIRE(arena.FreeSegments() == 2);
+        REQUIRE(arena.Alloc(TEST_VMEM_QUANTUM, 1) == TEST_VMEM_BASE + TEST_VMEM_QUANTUM);
+        REQUIRE(arena.Alloc(TEST_VMEM_QUANTUM, 3) == VMEM_FAILED);
+    }
+    SECTION("best fit") {
+        // Leave free holes of 3, 1 and 2 quanta
+        uintptr_t r[7];
+        size_t sizes[7] = { 1, 3, 1, 1, 1, 2, 1 };
+        for (size_t i = 0; i < 7; i++) {
+            r[i] = arena.Alloc(sizes[i] * TEST_VMEM_QUANTUM, 1);
+        }
+        arena.Free(r[1], 3 * TEST_VMEM_QUANTUM);
+        arena.Free(r[3], TEST_VMEM_QUANTUM);
+        arena.Free(r[5], 2 * TEST_VMEM_QUANTUM);
+        REQUIRE(arena.Alloc(2 * TEST_VMEM_QUANTUM, 1) == r[5]);
+        REQUIRE(arena.Alloc(TEST_VMEM_QUANTUM, 1) == r[3]);
+        REQUIRE(arena.Alloc(TEST_VMEM_QUANTUM, 1) == r[1]);
+    }
+    SECTION("freeing coalesces neighbours") {
+        uintptr_t a = arena.Alloc(TEST_VMEM_QUANTUM, 1);
+        uintptr_t b = arena.Alloc(TEST_VMEM_QUANTUM, 1);
+        uintptr_t c = arena.Alloc(TEST_VMEM_QUANTUM, 1);
+        arena.Free(a, TEST_VMEM_QUANTUM);
+        arena.Free(c, TEST_VMEM_QUANTUM);
+        REQUIRE(arena.FreeSegments() == 2);
+        arena.Free(b, TEST_VMEM_QUANTUM);
+        REQUIRE(arena.FreeSegments() == 1);
+        REQUIRE(arena.FreeSize() == TEST_VMEM_SIZE);
+        REQUIRE(arena.LargestFree() == TEST_VMEM_SIZE);
+        REQUIRE(arena.SpareSegments() == TEST_VMEM_SEGMENTS - 1);
+    }
+    SECTION("reserving fixed ranges") {
+        uintptr_t fixed = TEST_VMEM_BASE + 0x80000;
+        REQUIRE(arena.Reserve(fixed, 4 * TEST_VMEM_QUANTUM));
+        REQUIRE_FALSE(arena.Reserve(fixed + TEST_VMEM_QUANTUM, TEST_VMEM_QUANTUM));
+        REQUIRE_FALSE(arena.Reserve(TEST_VMEM_BASE + TEST_VMEM_SIZE, TEST_VMEM_QUANTUM));
+        REQUIRE(arena.FreeSegments() == 2);
+        REQUIRE(arena.LargestFree() == TEST_VMEM_SIZE - 0x80000 - 4 * TEST_VMEM_QUANTUM);
+        arena.Free(fixed, 4 * TEST_VMEM_QUANTUM);
+        REQUIRE(arena.FreeSegments() == 1);
+    }
+    SECTION("matches a reference model") {
+        // Random allocations and frees, checked against a page map
+        #define MODEL_PAGES (TEST_VMEM_SIZE / TEST_VMEM_QUANTUM)
+        static bool used[MODEL_PAGES];
+        static uintptr_t bases[64];
+        static size_t lengths[64];
+        for (size_t i = 0; i < MODEL_PAGES; i++) used[i] = false;
+        for (size_t i = 0; i < 64; i++) bases[i] = VMEM_FAILED;
+        uint32_t seed = 42;
+        for (size_t round = 0; round < 5000; round++) {
+            seed = seed * 1103515245 + 12345;
+            size_t slot = (seed >> 8) % 64;
+            if (bases[slot] == VMEM_FAILED) {
+                lengths[slot] = ((seed >> 16) % 64 + 1) * TEST_VMEM_QUANTUM;
+                size_t align = (size_t)TEST_VMEM_QUANTUM << ((seed >> 4) % 4);
+                bases[slot] = arena.Alloc(lengths[slot], align);
+                REQUIRE(bases[slot] != VMEM_FAILED);
+                REQUIRE((bases[slot] & (align - 1)) == 0);
+                for (size_t p = 0; p < lengths[slot] / TEST_VMEM_QUANTUM; p++) {
+                    size_t page = (bases[slot] - TEST_VMEM_BASE) / TEST_VMEM_QUANTUM + p;
+                    REQUIRE(page < MODEL_PAGES);
+                    REQUIRE_FALSE(used[page]);
+                    used[page] = true;
+                }
+            } else {
+                arena.Free(bases[slot], lengths[slot]);
+                for (size_t p = 0; p < lengths[slot] / TEST_VMEM_QUANTUM; p++) {
+                    used[(bases[slot] - TEST_VMEM_BASE) / TEST_VMEM_QUANTUM + p] = false;
+                }
+                bases[slot] = VMEM_FAILED;
+            }
+        }
+        for (size_t i = 0; i < 64; i++) {
+            if (bases[i] != VMEM_FAILED) arena.Free(bases[i], lengths[i]);
+        }
+        REQUIRE(arena.FreeSegments() == 1);
+        REQUIRE(arena.FreeSize() == TEST_VMEM_SIZE);
+    }
+}
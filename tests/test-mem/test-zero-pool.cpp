@@ -0,0 +1,103 @@
+/**
+ * @file test-zero-pool.cpp
+ * @author Keeton Feavel (keetonfeavel@cedarville.edu)
+ * @brief Pre-zeroed frame pool unit tests
+ * @version 0.1
+ * @date 2026-10-17
+ *
+ * @copyright Copyright the Panix Contributors (c) 2026
+ *
+ */
+#include <catch2/catch.hpp>
+#include <mem/zero_pool.cpp>
+#include <string.h>
+
+static bool frame_is_zero(size_t frame)
+{
+    uint8_t *page = (uint8_t *)kmap_temp(FRAME_TO_PHYS(frame));
+    bool zero = true;
+    for (size_t i = 0; i < PAGE_SIZE; i++) {
+        if (page[i] != 0) zero = false;
+    }
+    kunmap_temp(page);
+    return zero;
+}
+
+static void frame_fill(size_t frame, uint8_t value)
+{
+    void *page = kmap_temp(FRAME_TO_PHYS(frame));
+    memset(page, value, PAGE_SIZE);
+    kunmap_temp(page);
+}
+
+TEST_CASE("zero pool operations", "[zero_pool]") {
+    zero_pool_stats_t stats;
+    // The pool starts out empty, so the first frame is zeroed on the spot
+    size_t first = frames_alloc();
+    frame_fill(first, 0xA5);
+    frames_free(first);
+    REQUIRE(get_zeroed_frame() == first);
+    REQUIRE(frame_is_zero(first));
+    zero_pool_get_stats(&stats);
+    REQUIRE(stats.misses == 1);
+    REQUIRE(stats.hits == 0);
+    // Refilling tops it up with frames that still need zeroing
+    zero_pool_refill();
+    zero_pool_get_stats(&stats);
+    REQUIRE(stats.dirty == ZERO_POOL_FRAMES);
+    REQUIRE(stats.clean == 0);
+    for (size_t i = 0; i < dirty_count; i++) {
+        frame_fill(dirty_frames[i], 0xA5);
+    }
+
+    // The idle loop zeroes one frame at a time until none are left
+    size_t zeroed = 0;
+    while (zero_pool_idle()) zeroed++;
+    REQUIRE(zeroed == ZERO_POOL_FRAMES);
+    zero_pool_get_stats(&stats);
+    REQUIRE(stats.clean == ZERO_POOL_FRAMES);
+    REQUIRE(stats.dirty == 0);
+
+    // Frames zeroed ahead of time are hits
+    size_t frames[ZERO_POOL_FRAMES];
+    for (size_t i = 0; i < ZERO_POOL_FRAMES - ZERO_POOL_LOW; i++) {
+        frames[i] = get_zeroed_frame();
+        REQUIRE(frames[i] != SIZE_MAX);
+        REQUIRE(frame_is_zero(frames[i]));
+        frame_fill(frames[i], 0xFF);
+    }
+    zero_pool_get_stats(&stats);
+    REQUIRE(stats.hits == ZERO_POOL_FRAMES - ZERO_POOL_LOW);
+    REQUIRE(stats.misses == 1);
+    // Nothing is refilled until the pool drops below the low water mark
+    zero_pool_refill();
+    zero_pool_get_stats(&stats);
+    REQUIRE(stats.clean == ZERO_POOL_LOW);
+    REQUIRE(stats.dirty == 0);
+    size_t low = get_zeroed_frame();
+    REQUIRE(frame_is_zero(low));
+    zero_pool_refill();
+    zero_pool_get_stats(&stats);
+    REQUIRE(stats.clean + stats.dirty == ZERO_POOL_FRAMES);
+    REQUIRE(stats.dirty > 0);
+
+    // Shrinking gives up the frames waiting to be zeroed first
+    size_t held = zero_pool_reclaimable();
+    REQUIRE(held == stats.clean + stats.dirty);
+    REQUIRE(zero_pool_shrink(stats.dirty) == stats.dirty);
+    zero_pool_get_stats(&stats);
+    REQUIRE(stats.dirty == 0);
+    REQUIRE(zero_pool_reclaimable() == stats.clean);
+    // but not while the pool is being refilled
+    mutex_lock(&lock);
+    REQUIRE(zero_pool_shrink(SIZE_MAX) == 0);
+    mutex_unlock(&lock);
+    REQUIRE(zero_pool_shrink(SIZE_MAX) == stats.clean);
+    REQUIRE(zero_pool_reclaimable() == 0);
+
+    for (size_t i = 0; i < ZERO_POOL_FRAMES - ZERO_POOL_LOW; i++) {
+        frames_free(frames[i]);
+    }
+    frames_free(low);
+    frames_free(first);
+}